@@ -1,12 +1,15 @@
 #include "BVHNode.h"
 
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 
 #include "SDFObjects.h"
 #include "Misc.h"
+#include "PrimitiveProfiler.h"
 
 bool sdf::BVHNode::m_BoxBVH{ true };
+bool sdf::BVHNode::m_CostAwareSAH{ false };
 
 sdf::BVHNode::BVHNode(glm::vec3 const& origin, float radius, glm::vec3 const& extent)
 	: m_Origin{ origin }
@@ -39,6 +42,8 @@ std::pair<float, sdf::Object*> sdf::BVHNode::GetDistance(const glm::vec3& point,
 	//	return { boundingVolumeDistance, nullptr };
 	//}
 	
+	++outHitRecord.BVHNodesVisited;
+
 	//if leaf node just return the distance to the object
 	if (m_ObjectUPtr)
 	{
@@ -46,25 +51,29 @@ std::pair<float, sdf::Object*> sdf::BVHNode::GetDistance(const glm::vec3& point,
 	}
 	++outHitRecord.BVHDepth;
 
-	float const boundingVolumeDistance
-	{ 
-		[&]()
-		{
-			if (m_BoxBVH)
-			{
-				glm::vec3 const q{ glm::abs(point - m_Origin) - m_Extent };
-				return glm::length(glm::max(q, 0.0f)) + glm::min(glm::max(q.x, glm::max(q.y, q.z)), 0.0f);
-			}
-			return glm::length(point - m_Origin) - m_Radius;
-		}()
-	};
+	float const boundingVolumeDistance{ GetBoundDistance(point) };
 
 	//if the distance to the bounding volume is large enough return it 
-	if (boundingVolumeDistance > 0.1f)
+	if (boundingVolumeDistance > m_BoundMargin)
 	{
 		return { boundingVolumeDistance, nullptr };
 	}
 
+	//grouped leaf, the closest of its objects
+	if (not m_GroupedObjectVec.empty())
+	{
+		std::pair<float, sdf::Object*> closestResult{ FLT_MAX, nullptr };
+		for (sdf::Object* objectPtr : m_GroupedObjectVec)
+		{
+			float const distance{ objectPtr->GetDistance(point - objectPtr->Origin(), useEarlyOuts, outHitRecord) };
+			if (distance < closestResult.first)
+			{
+				closestResult = { distance, objectPtr };
+			}
+		}
+		return closestResult;
+	}
+
 	//we are in the bounding volume check the children
 	auto const leftResult{ m_LeftNodeUPtr->GetDistance(point, useEarlyOuts, outHitRecord) };
 	auto const rightResult{ m_RightNodeUPtr->GetDistance(point, useEarlyOuts, outHitRecord) };
@@ -76,6 +85,130 @@ std::pair<float, sdf::Object*> sdf::BVHNode::GetDistance(const glm::vec3& point,
 	return rightResult;
 }
 
+float sdf::BVHNode::GetBoundDistance(glm::vec3 const& point) const
+{
+	if (m_BoxBVH)
+	{
+		glm::vec3 const q{ glm::abs(point - m_Origin) - m_Extent };
+		return glm::length(glm::max(q, 0.0f)) + glm::min(glm::max(q.x, glm::max(q.y, q.z)), 0.0f);
+	}
+	return glm::length(point - m_Origin) - m_Radius;
+}
+
+void sdf::BVHNode::CollectNodes(std::vector<BVHNode const*>& outNodeVec) const
+{
+	outNodeVec.emplace_back(this);
+	if (m_LeftNodeUPtr)
+	{
+		m_LeftNodeUPtr->CollectNodes(outNodeVec);
+		m_RightNodeUPtr->CollectNodes(outNodeVec);
+	}
+}
+
+void sdf::BVHNode::CollectObjects(std::vector<sdf::Object*>& outObjectVec) const
+{
+	if (m_ObjectUPtr)
+	{
+		outObjectVec.emplace_back(m_ObjectUPtr);
+	}
+	outObjectVec.insert(outObjectVec.end(), m_GroupedObjectVec.begin(), m_GroupedObjectVec.end());
+	if (m_LeftNodeUPtr)
+	{
+		m_LeftNodeUPtr->CollectObjects(outObjectVec);
+		m_RightNodeUPtr->CollectObjects(outObjectVec);
+	}
+}
+
+void sdf::BVHNode::GetRayIntervals(glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection, float maxDistance, std::vector<std::pair<float, float>>& outIntervalVec) const
+{
+	CollectRayIntervals(IntersectBound(origin, direction, inverseDirection), origin, direction, inverseDirection, maxDistance, outIntervalVec);
+}
+
+void sdf::BVHNode::CollectRayIntervals(std::pair<float, float> const& interval, glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection, float maxDistance, std::vector<std::pair<float, float>>& outIntervalVec) const
+{
+	auto const [enterDistance, exitDistance] { interval };
+
+	//the ray misses this volume or only touches it behind the camera or beyond the max distance
+	if (enterDistance > exitDistance or exitDistance < 0.f or enterDistance > maxDistance)
+	{
+		return;
+	}
+
+	//leaf node, the padded early out radii keep the surface of its objects inside this interval
+	if (m_ObjectUPtr or not m_GroupedObjectVec.empty())
+	{
+		InsertRayInterval({ glm::max(enterDistance, 0.f), exitDistance }, outIntervalVec);
+		return;
+	}
+
+	std::pair<float, float> const leftInterval{ m_LeftNodeUPtr->IntersectBound(origin, direction, inverseDirection) };
+	std::pair<float, float> const rightInterval{ m_RightNodeUPtr->IntersectBound(origin, direction, inverseDirection) };
+	bool const leftFirst{ leftInterval.first <= rightInterval.first };
+
+	BVHNode const& nearNode{ leftFirst ? *m_LeftNodeUPtr : *m_RightNodeUPtr };
+	BVHNode const& farNode{ leftFirst ? *m_RightNodeUPtr : *m_LeftNodeUPtr };
+	nearNode.CollectRayIntervals(leftFirst ? leftInterval : rightInterval, origin, direction, inverseDirection, maxDistance, outIntervalVec);
+	farNode.CollectRayIntervals(leftFirst ? rightInterval : leftInterval, origin, direction, inverseDirection, maxDistance, outIntervalVec);
+}
+
+void sdf::BVHNode::InsertRayInterval(std::pair<float, float> const& interval, std::vector<std::pair<float, float>>& outIntervalVec)
+{
+	//front to back the place is nearly always the back
+	auto insertIt{ outIntervalVec.end() };
+	while (insertIt != outIntervalVec.begin() and std::prev(insertIt)->first > interval.first)
+	{
+		--insertIt;
+	}
+
+	//overlaps the one before it, grow that one instead
+	if (insertIt != outIntervalVec.begin() and interval.first <= std::prev(insertIt)->second)
+	{
+		--insertIt;
+		insertIt->second = glm::max(insertIt->second, interval.second);
+	}
+	else
+	{
+		insertIt = outIntervalVec.insert(insertIt, interval);
+	}
+
+	//the grown interval may now reach into the ones after it
+	auto mergedEndIt{ std::next(insertIt) };
+	while (mergedEndIt != outIntervalVec.end() and mergedEndIt->first <= insertIt->second)
+	{
+		insertIt->second = glm::max(insertIt->second, mergedEndIt->second);
+		++mergedEndIt;
+	}
+	outIntervalVec.erase(std::next(insertIt), mergedEndIt);
+}
+
+std::pair<float, float> sdf::BVHNode::IntersectBound(glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection) const
+{
+	//same margin as the sphere traced bounds, otherwise the jump could land past a surface the tracer would have found
+	if (m_BoxBVH)
+	{
+		glm::vec3 const extent{ m_Extent + m_BoundMargin };
+		glm::vec3 const t1{ (m_Origin - extent - origin) * inverseDirection };
+		glm::vec3 const t2{ (m_Origin + extent - origin) * inverseDirection };
+		glm::vec3 const tMin{ glm::min(t1, t2) };
+		glm::vec3 const tMax{ glm::max(t1, t2) };
+
+		return { glm::max(tMin.x, glm::max(tMin.y, tMin.z)), glm::min(tMax.x, glm::min(tMax.y, tMax.z)) };
+	}
+
+	float const radius{ m_Radius + m_BoundMargin };
+	glm::vec3 const toOrigin{ origin - m_Origin };
+	float const b{ glm::dot(toOrigin, direction) };
+	float const discriminant{ b * b - (glm::dot(toOrigin, toOrigin) - radius * radius) };
+
+	if (discriminant < 0.f)
+	{
+		return { FLT_MAX, -FLT_MAX };
+	}
+
+	float const discriminantRoot{ glm::sqrt(discriminant) };
+	return { -b - discriminantRoot, -b + discriminantRoot };
+}
+
 std::unique_ptr<sdf::BVHNode> sdf::BVHNode::CreateBVHNode(std::vector<sdf::Object*> const& objects)
 {
 	if (objects.empty())
@@ -83,6 +216,13 @@ std::unique_ptr<sdf::BVHNode> sdf::BVHNode::CreateBVHNode(std::vector<sdf::Objec
 		return nullptr;
 	}
 
+	//the cost aware split reorders the objects in place, so the whole tree works on one copy of them
+	if (m_CostAwareSAH)
+	{
+		std::vector<sdf::Object*> objectVec{ objects };
+		return CreateBVHNodeByCost(objectVec);
+	}
+
 	glm::vec3 const origin{ CalculateBVHOrigin(objects) };
 	float const radius{ CalculateBVHRadius(objects, origin) };
 	glm::vec3 const extent{ CalculateBVHExtent(objects, origin) };
@@ -105,7 +245,7 @@ std::unique_ptr<sdf::BVHNode> sdf::BVHNode::CreateBVHNode(std::vector<sdf::Objec
 	return std::move(nodeUPtr);
 }
 
-glm::vec3 sdf::BVHNode::CalculateBVHOrigin(std::vector<sdf::Object*> const& objects)
+glm::vec3 sdf::BVHNode::CalculateBVHOrigin(std::span<sdf::Object* const> objects)
 {
 	glm::vec3 const origin
 	{
@@ -119,7 +259,7 @@ glm::vec3 sdf::BVHNode::CalculateBVHOrigin(std::vector<sdf::Object*> const& obje
 	return origin / static_cast<float>(objects.size());
 }
 
-float sdf::BVHNode::CalculateBVHRadius(std::vector<sdf::Object*> const& objects, glm::vec3 const& origin)
+float sdf::BVHNode::CalculateBVHRadius(std::span<sdf::Object* const> objects, glm::vec3 const& origin)
 {
 	auto maxDistanceIt
 	{
@@ -140,7 +280,7 @@ float sdf::BVHNode::CalculateBVHRadius(std::vector<sdf::Object*> const& objects,
 	return 0.0f;
 }
 
-glm::vec3 sdf::BVHNode::CalculateBVHExtent(std::vector<sdf::Object*> const& objects, glm::vec3 const& origin)
+glm::vec3 sdf::BVHNode::CalculateBVHExtent(std::span<sdf::Object* const> objects, glm::vec3 const& origin)
 {
 	glm::vec3 extent{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
@@ -251,4 +391,142 @@ float sdf::BVHNode::CalculateBoundingBoxArea(std::vector<sdf::Object*> const& ob
 
 	glm::vec3 extents = maxBounds - minBounds;
 	return 2.0f * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
-}
\ No newline at end of file
+}
+
+float sdf::BVHNode::GetEvaluationCost(sdf::Object* object)
+{
+	float const profiledCost{ PrimitiveProfiler::GetAverageCost(object->GetType()) };
+	if (profiledCost > 0.f)
+	{
+		return profiledCost;
+	}
+	return object->GetEvaluationCost();
+}
+
+std::unique_ptr<sdf::BVHNode> sdf::BVHNode::CreateBVHNodeByCost(std::span<sdf::Object*> objects)
+{
+	glm::vec3 const origin{ CalculateBVHOrigin(objects) };
+	float const radius{ CalculateBVHRadius(objects, origin) };
+	glm::vec3 const extent{ CalculateBVHExtent(objects, origin) };
+
+	std::unique_ptr nodeUPtr{ std::make_unique<BVHNode>(origin, radius, extent) };
+
+	if (objects.size() == 1)
+	{
+		nodeUPtr->m_ObjectUPtr = objects[0];
+	}
+	else if (std::optional<size_t> const leftCount{ PartitionObjectsByCost(objects) })
+	{
+		nodeUPtr->m_LeftNodeUPtr = CreateBVHNodeByCost(objects.first(leftCount.value()));
+		nodeUPtr->m_RightNodeUPtr = CreateBVHNodeByCost(objects.subspan(leftCount.value()));
+	}
+	else
+	{
+		nodeUPtr->m_GroupedObjectVec.assign(objects.begin(), objects.end());
+	}
+
+	std::cout << "BVHNode created with " << objects.size() << " objects" << (nodeUPtr->m_GroupedObjectVec.empty() ? "" : " in one leaf") << std::endl;
+
+	return nodeUPtr;
+}
+
+namespace
+{
+	//bounds of the early out spheres, the origins alone give a single object no area
+	struct SplitBounds
+	{
+		glm::vec3 Min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		glm::vec3 Max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(sdf::Object const* object)
+		{
+			Min = glm::min(Min, object->Origin() - object->GetEarlyOutRadius());
+			Max = glm::max(Max, object->Origin() + object->GetEarlyOutRadius());
+		}
+		float GetArea() const
+		{
+			glm::vec3 const extents{ Max - Min };
+			return 2.0f * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+		}
+	};
+}
+
+std::optional<size_t> sdf::BVHNode::PartitionObjectsByCost(std::span<sdf::Object*> objects)
+{
+	size_t const objectCount{ objects.size() };
+
+	//a point inside this volume evaluates every object of a leaf
+	float leafCost{ 0.f };
+	SplitBounds parentBounds{};
+	for (sdf::Object* obj : objects)
+	{
+		leafCost += GetEvaluationCost(obj);
+		parentBounds.Grow(obj);
+	}
+	float const parentArea{ parentBounds.GetArea() };
+
+	float bestCost{ leafCost };
+	int bestAxis{ -1 };
+	size_t bestLeftCount{ 0 };
+
+	//ties broken by id, so sorting again along the best axis gives the exact order its sweep measured
+	auto const sortAlongAxis{ [objects](int axis)
+		{
+			std::sort(objects.begin(), objects.end(),
+				[axis](sdf::Object const* a, sdf::Object const* b)
+				{
+					if (a->Origin()[axis] != b->Origin()[axis])
+					{
+						return a->Origin()[axis] < b->Origin()[axis];
+					}
+					return a->GetProfileID() < b->GetProfileID();
+				});
+		} };
+
+	//area of the objects right of every split, swept once from the back instead of regrown per split
+	std::vector<float> rightAreaVec(objectCount);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		sortAlongAxis(axis);
+
+		SplitBounds rightBounds{};
+		for (size_t idx{ objectCount - 1 }; idx > 0; --idx)
+		{
+			rightBounds.Grow(objects[idx]);
+			rightAreaVec[idx] = rightBounds.GetArea();
+		}
+
+		SplitBounds leftBounds{};
+		float leftCost{ 0.f };
+		for (size_t leftCount{ 1 }; leftCount < objectCount; ++leftCount)
+		{
+			leftBounds.Grow(objects[leftCount - 1]);
+			leftCost += GetEvaluationCost(objects[leftCount - 1]);
+			float const rightCost{ leafCost - leftCost };
+
+			//chance of a point in the parent landing in either child, times what that child costs
+			float const leftProbability{ parentArea > 0.f ? leftBounds.GetArea() / parentArea : 1.f };
+			float const rightProbability{ parentArea > 0.f ? rightAreaVec[leftCount] / parentArea : 1.f };
+			float const cost{ 2.f * m_TraversalCost + leftProbability * leftCost + rightProbability * rightCost };
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestLeftCount = leftCount;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		return std::nullopt;
+	}
+
+	//the last sweep left the objects sorted along z
+	if (bestAxis != 2)
+	{
+		sortAlongAxis(bestAxis);
+	}
+	return bestLeftCount;
+}
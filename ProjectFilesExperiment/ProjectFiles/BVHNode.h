@@ -2,6 +2,8 @@
 #include "glm/glm.hpp"
 
 #include <memory>
+#include <optional>
+#include <span>
 #include <vector>
 
 namespace sdf
@@ -19,9 +21,28 @@ namespace sdf
 
 		std::pair<float, sdf::Object*> GetDistance(const glm::vec3& point, bool useEarlyOuts, HitRecord& outHitRecord) const;
 
+		//collects the [enter, exit] distances along the ray of every leaf bound the ray passes through,
+		//sorted front to back with overlapping ones merged
+		void GetRayIntervals(glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection, float maxDistance, std::vector<std::pair<float, float>>& outIntervalVec) const;
+
 		static std::unique_ptr<BVHNode> CreateBVHNode(std::vector<sdf::Object*> const& objects);
 
+		//distance to the box or sphere of this node, depending on m_BoxBVH
+		float GetBoundDistance(glm::vec3 const& point) const;
+		glm::vec3 const& GetOrigin() const { return m_Origin; }
+		float GetRadius() const { return m_Radius; }
+		//this node and every node below it
+		void CollectNodes(std::vector<BVHNode const*>& outNodeVec) const;
+		//every object in the leaves below this node
+		void CollectObjects(std::vector<sdf::Object*>& outObjectVec) const;
+
 		static bool m_BoxBVH;
+		//weighs the split by what the objects cost to evaluate instead of how many there are, only applies on the next build
+		static bool m_CostAwareSAH;
+		//nanoseconds of a bound test, a leaf holding several cheap objects saves two of them per visit
+		static constexpr float m_TraversalCost{ 4.f };
+		//distance at which a bounding volume is considered entered
+		static constexpr float m_BoundMargin{ 0.1f };
 	private:
 		glm::vec3 m_Origin{};
 		glm::vec3 m_Extent{ FLT_MAX, FLT_MAX, FLT_MAX };
@@ -30,12 +51,28 @@ namespace sdf
 		std::unique_ptr<BVHNode> m_RightNodeUPtr{ nullptr };
 
 		sdf::Object* m_ObjectUPtr{ nullptr };
+		//leaf with more than one object, only built by the cost aware sah
+		std::vector<sdf::Object*> m_GroupedObjectVec{};
 
-		static glm::vec3 CalculateBVHOrigin(std::vector<sdf::Object*> const& objects);
-		static float CalculateBVHRadius(std::vector<sdf::Object*> const& objects, glm::vec3 const& origin);
-		static glm::vec3 CalculateBVHExtent(std::vector<sdf::Object*> const& objects, glm::vec3 const& origin);
+		std::pair<float, float> IntersectBound(glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection) const;
+		//visits the nearer child first, so the leaf intervals come out close to sorted
+		void CollectRayIntervals(std::pair<float, float> const& interval, glm::vec3 const& origin, glm::vec3 const& direction, glm::vec3 const& inverseDirection, float maxDistance, std::vector<std::pair<float, float>>& outIntervalVec) const;
+		//inserts the interval at its place from the back and merges it with the ones it overlaps
+		static void InsertRayInterval(std::pair<float, float> const& interval, std::vector<std::pair<float, float>>& outIntervalVec);
+
+		static glm::vec3 CalculateBVHOrigin(std::span<sdf::Object* const> objects);
+		static float CalculateBVHRadius(std::span<sdf::Object* const> objects, glm::vec3 const& origin);
+		static glm::vec3 CalculateBVHExtent(std::span<sdf::Object* const> objects, glm::vec3 const& origin);
 		static std::pair<std::vector<sdf::Object*>, std::vector<sdf::Object*>> SplitObjects(std::vector<sdf::Object*> const& objects);
 		static float CalculateBoundingBoxArea(std::vector<sdf::Object*> const& objects);
+
+		//profiled cost of the primitive type when there is one, otherwise the object is timed on its own
+		static float GetEvaluationCost(sdf::Object* object);
+		//builds the subtree over the span, reordering it in place instead of copying every split
+		static std::unique_ptr<BVHNode> CreateBVHNodeByCost(std::span<sdf::Object*> objects);
+		//sorts the objects along the cheapest split axis and returns the size of the left half,
+		//empty when evaluating every object in one leaf is cheaper than any split
+		static std::optional<size_t> PartitionObjectsByCost(std::span<sdf::Object*> objects);
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "BoundSearch.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+sdf::BoundExcess sdf::FindWorstBoundExcess(glm::vec3 const& center, float halfSize, int uniformSampleCount, int refinedSampleCount, int refinementStepCount, uint32_t seed,
+	std::function<float(glm::vec3 const&)> const& getExcess, std::function<void(glm::vec3 const&, float)> const& onSample)
+{
+	std::mt19937 generator{ seed };
+	std::uniform_real_distribution<float> distribution{ -1.f, 1.f };
+	auto const randomOffset{ [&]() { return glm::vec3{ distribution(generator), distribution(generator), distribution(generator) }; } };
+
+	BoundExcess worst{};
+	auto const sample
+	{
+		[&](glm::vec3 const& point)
+		{
+			float const excess{ getExcess(point) };
+			if (onSample)
+			{
+				onSample(point, excess);
+			}
+			if (excess > worst.Excess)
+			{
+				worst = BoundExcess{ excess, point };
+			}
+			return excess;
+		}
+	};
+
+	std::vector<std::pair<float, glm::vec3>> sampleVec(uniformSampleCount);
+	for (std::pair<float, glm::vec3>& uniformSample : sampleVec)
+	{
+		uniformSample.second = center + randomOffset() * halfSize;
+		uniformSample.first = sample(uniformSample.second);
+	}
+
+	int const climbCount{ std::min(refinedSampleCount, uniformSampleCount) };
+	std::partial_sort(sampleVec.begin(), sampleVec.begin() + climbCount, sampleVec.end(),
+		[](auto const& a, auto const& b)
+		{
+			return a.first > b.first;
+		});
+
+	for (int refinedIdx{ 0 }; refinedIdx < climbCount; ++refinedIdx)
+	{
+		auto [bestExcess, bestPoint] { sampleVec[refinedIdx] };
+		float stepSize{ halfSize * 0.1f };
+		for (int stepIdx{ 0 }; stepIdx < refinementStepCount; ++stepIdx)
+		{
+			glm::vec3 const point{ bestPoint + randomOffset() * stepSize };
+			if (float const excess{ sample(point) };
+				excess > bestExcess)
+			{
+				bestExcess = excess;
+				bestPoint = point;
+			}
+			else
+			{
+				stepSize *= 0.9f;
+			}
+		}
+	}
+
+	return worst;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <functional>
+
+#include "glm/glm.hpp"
+
+namespace sdf
+{
+
+	struct BoundExcess
+	{
+		//bound distance minus surface distance at the worst point found
+		float Excess{ -FLT_MAX };
+		glm::vec3 Point{};
+	};
+
+	//uniform random samples in the cube around the center, then a random hill climb from the worst of them towards a larger excess
+	//getExcess returns the bound distance minus the surface distance, -FLT_MAX where the bound is not used
+	//onSample sees every evaluated point and its excess, the uniform ones and the climbing ones
+	BoundExcess FindWorstBoundExcess(glm::vec3 const& center, float halfSize, int uniformSampleCount, int refinedSampleCount, int refinementStepCount, uint32_t seed,
+		std::function<float(glm::vec3 const&)> const& getExcess, std::function<void(glm::vec3 const&, float)> const& onSample = {});
+
+}
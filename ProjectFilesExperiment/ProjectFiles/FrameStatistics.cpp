@@ -0,0 +1,110 @@
+#include "FrameStatistics.h"
+
+#include <algorithm>
+
+sdf::FrameStatistics::FrameStatistics()
+	: m_SlotVec(MaxThreadSlots)
+{
+}
+
+void sdf::FrameStatistics::Reset()
+{
+	//slots past the used ones were never written
+	std::fill(m_SlotVec.begin(), m_SlotVec.begin() + GetUsedThreadSlots(), Slot{});
+}
+
+void sdf::FrameStatistics::Record(HitRecord const& hitRecord)
+{
+	int const slotIdx{ GetThreadSlot() };
+	if (slotIdx == NoThreadSlot)
+	{
+		return;
+	}
+
+	Slot& slot{ m_SlotVec[slotIdx] };
+	Accumulator& accumulator{ hitRecord.DidHit ? slot.Hit : slot.Miss };
+
+	++accumulator.Count;
+	accumulator.StepSum += hitRecord.TotalSteps;
+	accumulator.EarlyOutSum += hitRecord.EarlyOutUsage;
+	accumulator.RefinementSum += hitRecord.RefinementSteps;
+	accumulator.BVHDepthSum += hitRecord.BVHDepth;
+	++accumulator.StepHistogram[std::clamp(hitRecord.TotalSteps / StepHistogramBinWidth, 0, StepHistogramBins - 1)];
+	++accumulator.BVHDepthHistogram[std::clamp(hitRecord.BVHDepth, 0, BVHDepthHistogramBins - 1)];
+}
+
+void sdf::FrameStatistics::Merge()
+{
+	Accumulator hitTotal{};
+	Accumulator missTotal{};
+
+	auto const add
+	{
+		[](Accumulator& total, Accumulator const& accumulator)
+		{
+			total.Count += accumulator.Count;
+			total.StepSum += accumulator.StepSum;
+			total.EarlyOutSum += accumulator.EarlyOutSum;
+			total.RefinementSum += accumulator.RefinementSum;
+			total.BVHDepthSum += accumulator.BVHDepthSum;
+			for (int binIdx{ 0 }; binIdx < StepHistogramBins; ++binIdx)
+			{
+				total.StepHistogram[binIdx] += accumulator.StepHistogram[binIdx];
+			}
+			for (int binIdx{ 0 }; binIdx < BVHDepthHistogramBins; ++binIdx)
+			{
+				total.BVHDepthHistogram[binIdx] += accumulator.BVHDepthHistogram[binIdx];
+			}
+		}
+	};
+
+	for (int slotIdx{ 0 }; slotIdx < GetUsedThreadSlots(); ++slotIdx)
+	{
+		add(hitTotal, m_SlotVec[slotIdx].Hit);
+		add(missTotal, m_SlotVec[slotIdx].Miss);
+	}
+
+	m_HitStats = Finalize(hitTotal);
+	m_MissStats = Finalize(missTotal);
+}
+
+sdf::ResultStats sdf::FrameStatistics::Finalize(Accumulator const& accumulator)
+{
+	ResultStats stats{};
+	stats.Count = static_cast<int>(accumulator.Count);
+
+	if (accumulator.Count == 0)
+	{
+		return stats;
+	}
+
+	stats.AverageStepsThroughScene = static_cast<int>(accumulator.StepSum / accumulator.Count);
+	stats.AverageEarlyOutSteps = static_cast<int>(accumulator.EarlyOutSum / accumulator.Count);
+	stats.AverageRefinementSteps = static_cast<int>(accumulator.RefinementSum / accumulator.Count);
+	stats.AverageBVHDepth = static_cast<int>(accumulator.BVHDepthSum / accumulator.Count);
+
+	stats.MedianSteps = GetStepPercentile(accumulator, 0.5f);
+	stats.P95Steps = GetStepPercentile(accumulator, 0.95f);
+	stats.P99Steps = GetStepPercentile(accumulator, 0.99f);
+
+	std::copy(accumulator.StepHistogram.begin(), accumulator.StepHistogram.end(), stats.StepHistogram.begin());
+	std::copy(accumulator.BVHDepthHistogram.begin(), accumulator.BVHDepthHistogram.end(), stats.BVHDepthHistogram.begin());
+
+	return stats;
+}
+
+int sdf::FrameStatistics::GetStepPercentile(Accumulator const& accumulator, float percentile)
+{
+	//upper edge of the bin the percentile falls in, so it is off by less than a bin width
+	int64_t const target{ static_cast<int64_t>(accumulator.Count * percentile) };
+	int64_t cumulative{ 0 };
+	for (int binIdx{ 0 }; binIdx < StepHistogramBins; ++binIdx)
+	{
+		cumulative += accumulator.StepHistogram[binIdx];
+		if (cumulative > target)
+		{
+			return (binIdx + 1) * StepHistogramBinWidth - 1;
+		}
+	}
+	return StepHistogramBins * StepHistogramBinWidth - 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Misc.h"
+
+namespace sdf
+{
+
+	//hit and miss statistics gathered while tracing, every thread counts into its own slot and the slots get merged once per frame
+	class FrameStatistics final
+	{
+	public:
+		FrameStatistics();
+		~FrameStatistics() = default;
+
+		FrameStatistics(const FrameStatistics&) = delete;
+		FrameStatistics(FrameStatistics&&) noexcept = delete;
+		FrameStatistics& operator=(const FrameStatistics&) = delete;
+		FrameStatistics& operator=(FrameStatistics&&) noexcept = delete;
+
+		void Reset();
+		//safe to call from any thread between Reset and Merge
+		void Record(HitRecord const& hitRecord);
+		void Merge();
+
+		ResultStats const& GetStats(bool miss) const { return miss ? m_MissStats : m_HitStats; }
+	private:
+		struct Accumulator
+		{
+			int64_t Count{};
+			int64_t StepSum{};
+			int64_t EarlyOutSum{};
+			int64_t RefinementSum{};
+			int64_t BVHDepthSum{};
+			std::array<uint32_t, StepHistogramBins> StepHistogram{};
+			std::array<uint32_t, BVHDepthHistogramBins> BVHDepthHistogram{};
+		};
+
+		struct alignas(CacheLineSize) Slot
+		{
+			Accumulator Hit{};
+			Accumulator Miss{};
+		};
+
+		std::vector<Slot> m_SlotVec{};
+		ResultStats m_HitStats{};
+		ResultStats m_MissStats{};
+
+		static ResultStats Finalize(Accumulator const& accumulator);
+		static int GetStepPercentile(Accumulator const& accumulator, float percentile);
+	};
+
+}
@@ -1,6 +1,9 @@
 #include "GUI.h"
 
+#include <thread>
+
 #include <imgui.h>
+#include <imgui_plot.h>
 #include <SDL_events.h>
 #include <SDL_render.h>
 #include <imgui_impl_sdl2.h>
@@ -11,6 +14,30 @@
 #include "BVHNode.h"
 #include "Misc.h"
 #include "SDFObjects.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include "PerfCounters.h"
+#include "PrimitiveProfiler.h"
+
+namespace
+{
+    //plots the bins up to the last filled one, the tail of the step histogram is almost always empty
+    template<size_t Size>
+    void PlotBins(char const* label, std::array<int, Size> const& binArr)
+    {
+        auto const lastFilledIt{ std::find_if(binArr.rbegin(), binArr.rend(), [](int count) { return count != 0; }) };
+        int const binCount{ std::max(static_cast<int>(binArr.rend() - lastFilledIt), 1) };
+
+        auto const getter
+        {
+            [](void* data, int idx)
+            {
+                return static_cast<float>(static_cast<int const*>(data)[idx]);
+            }
+        };
+        ImGui::PlotHistogram(label, getter, const_cast<int*>(binArr.data()), binCount, 0, nullptr, 0.f, FLT_MAX, ImVec2{ 0, 40 });
+    }
+}
 
 void GUI::Initialize(SDL_Window* windowPtr, SDL_Renderer* rendererPtr)
 {
@@ -33,9 +60,12 @@ void GUI::BeginFrame(sdf::Engine& engine)
 	static ImVec2 const settingsPosition{ 0, 0 };
 	static ImVec2 const statsDimensions{ 150, 300 };
 	static ImVec2 const statsPosition{ engine.GetRenderer().GetWindowDimensions().x - statsDimensions.x, 0 };
+	static ImVec2 const profilerDimensions{ 300, 230 };
+	static ImVec2 const profilerPosition{ 0, engine.GetRenderer().GetWindowDimensions().y - profilerDimensions.y };
 
 	LoadSettingsWindow(engine, "Settings", settingsPosition, settingsDimensions);
 	LoadStatsWindow(engine, "Statistics", statsPosition, statsDimensions);
+	LoadProfilerWindow(engine, "Frame Timing", profilerPosition, profilerDimensions);
 }
 
 void GUI::EndFrame()
@@ -76,13 +106,36 @@ void GUI::LoadSettingsWindow(sdf::Engine& engine, std::string const& name, ImVec
     if (sdf::Scene::m_UseBVH)
     {
         ImGui::Checkbox("Box BVH", &sdf::BVHNode::m_BoxBVH);
+        ImGui::Checkbox("Bound Jumps", &sdf::Scene::m_UseBoundJumps);
+        ImGui::Checkbox("Cost Aware SAH", &sdf::BVHNode::m_CostAwareSAH);
+        //the gui runs while the render thread waits, so the scenes are safe to rebuild
+        if (ImGui::Button("Rebuild BVH"))
+        {
+            engine.RebuildBVHs();
+        }
     }
 	else
 	{
 		sdf::BVHNode::m_BoxBVH = false;
+		sdf::Scene::m_UseBoundJumps = false;
 	}
 	//ImGui::InputInt("BVH Stepss", &sdf::Scene::m_BVHSteps);
 
+    ImGui::Checkbox("Step Scale", &sdf::Object::m_UseStepScale);
+
+    ImGui::Checkbox("Hit Refinement", &sdf::Scene::m_UseHitRefinement);
+    if (sdf::Scene::m_UseHitRefinement)
+    {
+        ImGui::InputFloat("Coarse Hit", &sdf::Scene::m_RefinementHitDistance);
+    }
+
+    ImGui::Checkbox("Reprojection", &sdf::Renderer::m_UseReprojection);
+    if (sdf::Renderer::m_UseReprojection)
+    {
+        ImGui::SliderFloat("Safety", &sdf::Renderer::m_ReprojectionSafety, 0.f, 0.5f);
+        ImGui::SliderFloat("Depth Threshold", &sdf::Renderer::m_ReprojectionDepthThreshold, 0.01f, 1.f);
+    }
+
 	ImGui::Text("Scene complexity: ");
     ImGui::Combo("|", &engine.SetCurrentSceneID(), engine.GetSceneComplexities(), engine.GetSceneComplexityCount());
 
@@ -102,6 +155,64 @@ void GUI::LoadSettingsWindow(sdf::Engine& engine, std::string const& name, ImVec
 	}
     
 
+    ImGui::SliderFloat("Scale", &sdf::Renderer::m_RenderScale, 0.25f, 1.f);
+    ImGui::Checkbox("Checkerboard", &sdf::Renderer::m_UseCheckerboard);
+    ImGui::Checkbox("Adaptive", &sdf::Renderer::m_UseAdaptiveSampling);
+    if (sdf::Renderer::m_UseAdaptiveSampling)
+    {
+        ImGui::SliderFloat("Depth Diff", &sdf::Renderer::m_AdaptiveDepthThreshold, 0.f, 0.5f);
+    }
+
+    int debugView{ static_cast<int>(sdf::Renderer::m_DebugView) };
+    if (ImGui::Combo("Debug View", &debugView, [](void*, int idx, char const** outText) { *outText = sdf::Renderer::GetDebugViewName(idx); return true; }, nullptr, sdf::Renderer::DebugViewCount))
+    {
+        sdf::Renderer::m_DebugView = static_cast<sdf::Renderer::DebugView>(debugView);
+    }
+    if (sdf::Renderer::m_DebugView != sdf::Renderer::DebugView::None and ImGui::Button("Save Heatmaps"))
+    {
+        if (engine.GetRenderer().SaveDebugViewsToImages(std::string{ engine.GetSceneComplexities()[engine.SetCurrentSceneID()] } + "_heatmap"))
+        {
+            std::cout << "Heatmaps saved successfully" << "\n";
+        }
+    }
+
+    ImGui::Checkbox("Accumulate", &sdf::Renderer::m_UseAccumulation);
+    if (sdf::Renderer::m_UseAccumulation)
+    {
+        ImGui::InputInt("Max Samples", &sdf::Renderer::m_MaxAccumulatedSamples);
+    }
+
+    ImGui::Checkbox("Force Render", &engine.SetForceRender());
+    ImGui::Checkbox("Pipelining", &engine.SetUsePipelining());
+    ImGui::Checkbox("Statistics", &sdf::Renderer::m_UseStatistics);
+    ImGui::Checkbox("sRGB", &sdf::Renderer::m_UseSRGB);
+    ImGui::Checkbox("Lock Texture", &sdf::Renderer::m_UseTextureLocking);
+    ImGui::Checkbox("Primitive Costs", &sdf::PrimitiveProfiler::m_Enabled);
+    ImGui::Checkbox("Packing Time", &sdf::Renderer::m_ProfilePacking);
+    if (sdf::PrimitiveProfiler::m_Enabled and ImGui::Button("Save Costs"))
+    {
+        if (sdf::PrimitiveProfiler::Export("primitive_costs.csv", engine.GetCurrentScene().GetObjects()))
+        {
+            std::cout << "Primitive costs saved successfully" << "\n";
+        }
+    }
+    ImGui::Checkbox("Record Trace", &sdf::TraceRecorder::m_Enabled);
+    if (ImGui::Button("Save Trace"))
+    {
+        engine.RequestTraceExport();
+    }
+
+    sdf::QualityGovernor& governor{ engine.GetGovernor() };
+    //switching it off puts the quality back right away, not only once something else triggers a render
+    if (ImGui::Checkbox("Governor", &governor.SetEnabled()) and not governor.IsEnabled())
+    {
+        governor.RestoreUserQuality();
+    }
+    if (governor.SetEnabled())
+    {
+        ImGui::InputFloat("Target FPS", &governor.SetTargetFrameRate());
+    }
+
 	ImGui::Text("Time Benchmark: ");
 	ImGui::InputFloat("##", &timer.SetBenchmarkTargetFrames());
 
@@ -124,7 +235,7 @@ void GUI::LoadSettingsWindow(sdf::Engine& engine, std::string const& name, ImVec
             std::cout << "Benchmark image saved successfully" << "\n";
         }
 
-		timer.StartBenchmark(engine.GetSceneComplexities()[engine.SetCurrentSceneID()], hitStats, missStats);
+		timer.StartBenchmark(engine.GetSceneComplexities()[engine.SetCurrentSceneID()], engine.GetCurrentScene().IsCostAwareBVH(), hitStats, missStats);
     }
 
     ImGui::End();
@@ -137,7 +248,74 @@ void GUI::LoadStatsWindow(sdf::Engine& engine, std::string const& name, ImVec2 c
     ImGui::SetWindowSize(size, ImGuiCond_Once);
 
     ImGui::Value("FPS", ImGui::GetIO().Framerate);
+    ImGui::Value("Samples", engine.GetRenderer().GetAccumulatedSamples());
+
+    if (sdf::QualityGovernor const& governor{ engine.GetGovernor() };
+        governor.IsEnabled())
+    {
+        ImGui::Separator();
+        ImGui::Text("Quality level: %d", governor.GetQualityLevel());
+        ImGui::Text("Render ms: %.2f", governor.GetAverageRenderTime() * 1000.f);
+        ImGui::Text("Scale: %.2f", sdf::Renderer::m_RenderScale);
+        ImGui::Text("Max steps: %d", sdf::Renderer::m_MaxSteps);
+        ImGui::Text("Hit distance: %.4f", sdf::Renderer::m_HitDistance);
+    }
+
+    //the packing time is summed over every thread, so compare it against the time all threads had
+    if (sdf::Renderer::m_ProfilePacking)
+    {
+        float const packingTime{ engine.GetRenderer().GetPackingTime() };
+        float const threadTime{ engine.GetGovernor().GetAverageRenderTime() * 1000.f * std::thread::hardware_concurrency() };
+        ImGui::Separator();
+        ImGui::Text("Pack ms: %.3f", packingTime);
+        ImGui::Text("Pack share: %.1f%%", threadTime > 0.f ? packingTime / threadTime * 100.f : 0.f);
+    }
+
+    ImGui::Separator();
+    if (sdf::PerfCounters::IsAvailable())
+    {
+        sdf::PerfSample const traceSample{ sdf::PerfCounters::GetStageSample(sdf::PerfStage::Trace) };
+        sdf::PerfSample const buildSample{ sdf::PerfCounters::GetStageSample(sdf::PerfStage::Build) };
+        ImGui::Text("Trace IPC: %.2f", traceSample.GetInstructionsPerCycle());
+        ImGui::Text("L1D miss/ki: %.2f", traceSample.GetPerKiloInstruction(sdf::PerfCounter::L1DMisses));
+        ImGui::Text("LLC miss/ki: %.2f", traceSample.GetPerKiloInstruction(sdf::PerfCounter::LLCMisses));
+        ImGui::Text("Branch miss/ki: %.2f", traceSample.GetPerKiloInstruction(sdf::PerfCounter::BranchMisses));
+        ImGui::Text("Build IPC: %.2f", buildSample.GetInstructionsPerCycle());
+    }
+    ImGui::TextWrapped("Counters: %s", sdf::PerfCounters::GetStatus());
+
+    if (sdf::PrimitiveProfiler::m_Enabled)
+    {
+        ImGui::Separator();
+        ImGui::Text("Evaluations, early outs, ns");
+        for (int typeIdx{ 0 }; typeIdx < sdf::PrimitiveTypeCount; ++typeIdx)
+        {
+            sdf::PrimitiveType const type{ static_cast<sdf::PrimitiveType>(typeIdx) };
+            if (sdf::PrimitiveProfiler::TypeCost const& typeCost{ sdf::PrimitiveProfiler::GetTypeCost(type) };
+                typeCost.Evaluations + typeCost.EarlyOuts > 0)
+            {
+                ImGui::Text("%s: %lld %lld %.1f", sdf::GetPrimitiveTypeName(type), static_cast<long long>(typeCost.Evaluations), static_cast<long long>(typeCost.EarlyOuts), typeCost.AverageCost);
+            }
+        }
+
+        if (ImGui::TreeNode("Objects"))
+        {
+            auto const& objectUPtrVec{ engine.GetCurrentScene().GetObjects() };
+            for (size_t objectIdx{ 0 }; objectIdx < objectUPtrVec.size(); ++objectIdx)
+            {
+                sdf::PrimitiveProfiler::ObjectCost const& objectCost{ sdf::PrimitiveProfiler::GetObjectCost(objectUPtrVec[objectIdx]->GetProfileID()) };
+                ImGui::Text("%d %s: %lld %lld", static_cast<int>(objectIdx), objectUPtrVec[objectIdx]->GetTypeName(), static_cast<long long>(objectCost.Evaluations), static_cast<long long>(objectCost.EarlyOuts));
+            }
+            ImGui::TreePop();
+        }
+    }
     
+    if (not sdf::Renderer::m_UseStatistics)
+    {
+        ImGui::End();
+        return;
+    }
+
     sdf::Renderer const& renderer{ engine.GetRenderer() };
     
 	sdf::ResultStats const hitStats{ renderer.GetCollisionStats(false) };
@@ -148,13 +326,70 @@ void GUI::LoadStatsWindow(sdf::Engine& engine, std::string const& name, ImVec2 c
     ImGui::Text("Rays hit: %d", hitStats.Count);
 	ImGui::Text("Avg steps: %d", hitStats.AverageStepsThroughScene);
 	ImGui::Text("Avg early out: %d", hitStats.AverageEarlyOutSteps);
+	ImGui::Text("Avg refine steps: %d", hitStats.AverageRefinementSteps);
 	ImGui::Text("Avg BVH depth: %d", hitStats.AverageBVHDepth);
+	ImGui::Text("Steps p50/95/99: %d/%d/%d", hitStats.MedianSteps, hitStats.P95Steps, hitStats.P99Steps);
+    PlotBins("##HitSteps", hitStats.StepHistogram);
+    PlotBins("##HitDepth", hitStats.BVHDepthHistogram);
     ImGui::Separator();
     ImGui::Text("Miss Statistics");
     ImGui::Text("Rays missed: %d", missStats.Count);
 	ImGui::Text("Avg steps: %d", missStats.AverageStepsThroughScene);
 	ImGui::Text("Avg early out: %d", missStats.AverageEarlyOutSteps);
+	ImGui::Text("Avg refine steps: %d", missStats.AverageRefinementSteps);
 	ImGui::Text("Avg BVH depth: %d", missStats.AverageBVHDepth);
+	ImGui::Text("Steps p50/95/99: %d/%d/%d", missStats.MedianSteps, missStats.P95Steps, missStats.P99Steps);
+    PlotBins("##MissSteps", missStats.StepHistogram);
+    PlotBins("##MissDepth", missStats.BVHDepthHistogram);
+
+    ImGui::End();
+}
+
+void GUI::LoadProfilerWindow(sdf::Engine& engine, std::string const& name, ImVec2 const& pos, ImVec2 const& size)
+{
+    ImGui::Begin(name.c_str());
+    ImGui::SetWindowPos(pos, ImGuiCond_Once);
+    ImGui::SetWindowSize(size, ImGuiCond_Once);
+
+    sdf::Profiler const& profiler{ engine.GetProfiler() };
+    constexpr int stageCount{ sdf::Profiler::StageCount };
+
+    static constexpr std::array<ImU32, stageCount> stageColorArr
+    {
+        IM_COL32(160, 160, 160, 255),
+        IM_COL32(230, 90, 70, 255),
+        IM_COL32(240, 180, 60, 255),
+        IM_COL32(90, 190, 90, 255),
+        IM_COL32(80, 150, 230, 255),
+        IM_COL32(190, 110, 220, 255)
+    };
+
+    //every line is the sum of its stage and the ones before it, so the gaps between the lines are the stages
+    std::array<float const*, stageCount> stackedTimeArr{};
+    for (int stageIdx{ 0 }; stageIdx < stageCount; ++stageIdx)
+    {
+        stackedTimeArr[stageIdx] = profiler.GetStackedTimes(stageIdx);
+    }
+    float const* totalTimePtr{ stackedTimeArr[stageCount - 1] };
+    float const maxTime{ *std::max_element(totalTimePtr, totalTimePtr + sdf::Profiler::FrameCount) };
+
+    ImGui::PlotConfig plotConfig{};
+    plotConfig.values.ys_list = stackedTimeArr.data();
+    plotConfig.values.ys_count = stageCount;
+    plotConfig.values.count = sdf::Profiler::FrameCount;
+    plotConfig.values.colors = stageColorArr.data();
+    plotConfig.scale.min = 0.f;
+    plotConfig.scale.max = std::max(maxTime, 1.f);
+    plotConfig.frame_size = ImVec2{ ImGui::GetContentRegionAvail().x, 80 };
+    ImGui::Plot("##StageTimes", plotConfig);
+
+    ImGui::Text("%-8s %6s %6s %6s %6s", "ms", "last", "p50", "p95", "p99");
+    for (int stageIdx{ 0 }; stageIdx < stageCount; ++stageIdx)
+    {
+        sdf::Profiler::StagePercentiles const& percentiles{ profiler.GetPercentiles(stageIdx) };
+        ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(stageColorArr[stageIdx]), "%-8s %6.2f %6.2f %6.2f %6.2f",
+            sdf::Profiler::GetStageName(stageIdx), profiler.GetLastStageTime(stageIdx), percentiles.P50, percentiles.P95, percentiles.P99);
+    }
 
     ImGui::End();
 }
@@ -24,4 +24,5 @@ namespace GUI
 
 	void LoadSettingsWindow(sdf::Engine& engine, std::string const& name, ImVec2 const& pos, ImVec2 const& size);
 	void LoadStatsWindow(sdf::Engine& engine, std::string const& name, ImVec2 const& pos, ImVec2 const& size);
+	void LoadProfilerWindow(sdf::Engine& engine, std::string const& name, ImVec2 const& pos, ImVec2 const& size);
 }
\ No newline at end of file
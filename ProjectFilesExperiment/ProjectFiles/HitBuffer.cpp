@@ -0,0 +1,89 @@
+#include "HitBuffer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "glm/gtc/packing.hpp"
+
+namespace
+{
+	template<typename T>
+	T Saturate(int value)
+	{
+		return static_cast<T>(std::clamp(value, 0, static_cast<int>(std::numeric_limits<T>::max())));
+	}
+
+	uint8_t QuantizeChannel(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+}
+
+void sdf::HitBuffer::Resize(uint32_t nrOfPixels)
+{
+	m_DepthVec.resize(nrOfPixels);
+	m_ObjectIDVec.resize(nrOfPixels, MissID);
+	m_StepVec.resize(nrOfPixels);
+	m_EarlyOutVec.resize(nrOfPixels);
+	m_RefinementStepVec.resize(nrOfPixels);
+	m_BVHDepthVec.resize(nrOfPixels);
+	m_BVHNodeVec.resize(nrOfPixels);
+	m_PrimitiveEvaluationVec.resize(nrOfPixels);
+	m_ShadeVec.resize(nrOfPixels);
+}
+
+void sdf::HitBuffer::Store(uint32_t pixelIdx, HitRecord const& hitRecord)
+{
+	//positive halves order the same as their bits, one step down undoes rounding up
+	uint16_t depth{ glm::packHalf1x16(hitRecord.Distance) };
+	if (depth > 0 and glm::unpackHalf1x16(depth) > hitRecord.Distance)
+	{
+		--depth;
+	}
+	m_DepthVec[pixelIdx] = depth;
+
+	m_ObjectIDVec[pixelIdx] = hitRecord.DidHit ? static_cast<uint8_t>(std::max(hitRecord.ObjectID, 0) % MissID) : MissID;
+	m_StepVec[pixelIdx] = Saturate<uint16_t>(hitRecord.TotalSteps);
+	m_EarlyOutVec[pixelIdx] = Saturate<uint16_t>(hitRecord.EarlyOutUsage);
+	m_RefinementStepVec[pixelIdx] = Saturate<uint8_t>(hitRecord.RefinementSteps);
+	m_BVHDepthVec[pixelIdx] = Saturate<uint8_t>(hitRecord.BVHDepth);
+	m_BVHNodeVec[pixelIdx] = Saturate<uint16_t>(hitRecord.BVHNodesVisited);
+	m_PrimitiveEvaluationVec[pixelIdx] = Saturate<uint16_t>(hitRecord.PrimitiveEvaluations);
+	m_ShadeVec[pixelIdx] = static_cast<uint32_t>(QuantizeChannel(hitRecord.Shade.r)) << 16
+		| static_cast<uint32_t>(QuantizeChannel(hitRecord.Shade.g)) << 8
+		| static_cast<uint32_t>(QuantizeChannel(hitRecord.Shade.b));
+}
+
+sdf::HitRecord sdf::HitBuffer::Load(uint32_t pixelIdx) const
+{
+	HitRecord hitRecord{ LoadShading(pixelIdx) };
+	hitRecord.ObjectID = hitRecord.DidHit ? m_ObjectIDVec[pixelIdx] : -1;
+	hitRecord.Distance = GetDistance(pixelIdx);
+	hitRecord.EarlyOutUsage = m_EarlyOutVec[pixelIdx];
+	hitRecord.RefinementSteps = m_RefinementStepVec[pixelIdx];
+	hitRecord.BVHDepth = m_BVHDepthVec[pixelIdx];
+	hitRecord.BVHNodesVisited = m_BVHNodeVec[pixelIdx];
+	hitRecord.PrimitiveEvaluations = m_PrimitiveEvaluationVec[pixelIdx];
+	return hitRecord;
+}
+
+sdf::HitRecord sdf::HitBuffer::LoadShading(uint32_t pixelIdx) const
+{
+	HitRecord hitRecord{};
+	hitRecord.DidHit = DidHit(pixelIdx);
+	hitRecord.TotalSteps = m_StepVec[pixelIdx];
+
+	uint32_t const shade{ m_ShadeVec[pixelIdx] };
+	hitRecord.Shade = ColorRGB
+	{
+		static_cast<float>((shade >> 16) & 0xFF) / 255.f,
+		static_cast<float>((shade >> 8) & 0xFF) / 255.f,
+		static_cast<float>(shade & 0xFF) / 255.f
+	};
+	return hitRecord;
+}
+
+float sdf::HitBuffer::GetDistance(uint32_t pixelIdx) const
+{
+	return glm::unpackHalf1x16(m_DepthVec[pixelIdx]);
+}
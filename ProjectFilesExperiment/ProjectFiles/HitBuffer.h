@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Misc.h"
+
+namespace sdf
+{
+
+	//per pixel trace results split into quantized streams, so every pass only pulls the bytes it reads
+	//17 bytes per pixel instead of the 48 of a HitRecord
+	class HitBuffer final
+	{
+	public:
+		static constexpr uint8_t MissID{ 0xFF };
+
+		void Resize(uint32_t nrOfPixels);
+
+		void Store(uint32_t pixelIdx, HitRecord const& hitRecord);
+		//every field, for passes that copy or blend whole records
+		HitRecord Load(uint32_t pixelIdx) const;
+		//only hit, shade and steps, the fields ShadeHitRecord looks at
+		HitRecord LoadShading(uint32_t pixelIdx) const;
+
+		bool DidHit(uint32_t pixelIdx) const { return m_ObjectIDVec[pixelIdx] != MissID; }
+		float GetDistance(uint32_t pixelIdx) const;
+
+		std::vector<uint8_t> const& GetObjectIDs() const { return m_ObjectIDVec; }
+		std::vector<uint16_t> const& GetSteps() const { return m_StepVec; }
+		std::vector<uint16_t> const& GetEarlyOuts() const { return m_EarlyOutVec; }
+		std::vector<uint8_t> const& GetRefinementSteps() const { return m_RefinementStepVec; }
+		std::vector<uint8_t> const& GetBVHDepths() const { return m_BVHDepthVec; }
+		std::vector<uint16_t> const& GetBVHNodesVisited() const { return m_BVHNodeVec; }
+		std::vector<uint16_t> const& GetPrimitiveEvaluations() const { return m_PrimitiveEvaluationVec; }
+	private:
+		//half floats, rounded down so reprojected start distances stay in front of the surface
+		std::vector<uint16_t> m_DepthVec{};
+		//wraps past 254 objects, MissID marks a miss
+		std::vector<uint8_t> m_ObjectIDVec{};
+		//counters saturate instead of wrapping
+		std::vector<uint16_t> m_StepVec{};
+		std::vector<uint16_t> m_EarlyOutVec{};
+		std::vector<uint8_t> m_RefinementStepVec{};
+		std::vector<uint8_t> m_BVHDepthVec{};
+		std::vector<uint16_t> m_BVHNodeVec{};
+		std::vector<uint16_t> m_PrimitiveEvaluationVec{};
+		//8 bit per channel object color, 0x00RRGGBB
+		std::vector<uint32_t> m_ShadeVec{};
+	};
+
+}
@@ -1,4 +1,12 @@
 #pragma once
+#include <functional>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+#include <vector>
+
 #include "ColorRGB.h"
 
 namespace sdf
@@ -7,25 +15,128 @@ namespace sdf
 	struct HitRecord
 	{
 		bool DidHit{ false };
+		int ObjectID{ -1 };
 
 		float Distance{};
 
 		int TotalSteps{};
 		int EarlyOutUsage{};
+		int RefinementSteps{};
 
 		int BVHDepth{};
+		//every node the distance queries entered, leaves included
+		int BVHNodesVisited{};
+		//distance functions that ran in full, early outs not included
+		int PrimitiveEvaluations{};
+		//smallest distance to the scene over the distance travelled at any step, the widest cone around the ray that nothing entered
+		float ClearConeRatio{ FLT_MAX };
 
 		ColorRGB Shade{ 0.f, 0.f, 0.f };
 	};
 
+	//steps get binned in groups of StepHistogramBinWidth, the last bin also holds everything above it
+	constexpr int StepHistogramBins{ 128 };
+	constexpr int StepHistogramBinWidth{ 4 };
+	constexpr int BVHDepthHistogramBins{ 32 };
+
 	struct ResultStats
 	{
 		int Count{};
 
 		int AverageStepsThroughScene{};
 		int AverageEarlyOutSteps{};
+		int AverageRefinementSteps{};
 
 		int AverageBVHDepth{};
+
+		int MedianSteps{};
+		int P95Steps{};
+		int P99Steps{};
+
+		std::array<int, StepHistogramBins> StepHistogram{};
+		std::array<int, BVHDepthHistogramBins> BVHDepthHistogram{};
+	};
+
+	//per thread data gets padded to this, so threads never share a cache line
+	constexpr size_t CacheLineSize{ 64 };
+	//threads hand their slot back when they exit, so this only limits how many are alive at once
+	constexpr int MaxThreadSlots{ 128 };
+
+	//returned once every slot belongs to a live thread, the caller drops what it wanted to record
+	constexpr int NoThreadSlot{ -1 };
+
+	//highest slot ever handed out plus one
+	inline std::atomic<int> ThreadSlotCount{ 0 };
+
+	//slots of threads that exited, handed out again before new ones
+	struct ThreadSlotPool
+	{
+		std::mutex Mutex{};
+		std::vector<int> FreeSlotVec{};
 	};
 
+	//never destroyed, pool threads can still exit after the statics are gone
+	inline ThreadSlotPool& GetThreadSlotPool()
+	{
+		static ThreadSlotPool* const threadSlotPoolPtr{ new ThreadSlotPool{} };
+		return *threadSlotPoolPtr;
+	}
+
+	//owns the slot of one thread and puts it back in the pool when the thread exits
+	class ThreadSlotHandle final
+	{
+	public:
+		ThreadSlotHandle()
+		{
+			ThreadSlotPool& pool{ GetThreadSlotPool() };
+			std::lock_guard<std::mutex> lock{ pool.Mutex };
+			if (not pool.FreeSlotVec.empty())
+			{
+				m_Slot = pool.FreeSlotVec.back();
+				pool.FreeSlotVec.pop_back();
+			}
+			else if (ThreadSlotCount.load(std::memory_order_relaxed) < MaxThreadSlots)
+			{
+				m_Slot = ThreadSlotCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		~ThreadSlotHandle()
+		{
+			if (m_Slot != NoThreadSlot)
+			{
+				ThreadSlotPool& pool{ GetThreadSlotPool() };
+				std::lock_guard<std::mutex> lock{ pool.Mutex };
+				pool.FreeSlotVec.emplace_back(m_Slot);
+			}
+		}
+
+		ThreadSlotHandle(const ThreadSlotHandle&) = delete;
+		ThreadSlotHandle(ThreadSlotHandle&&) noexcept = delete;
+		ThreadSlotHandle& operator=(const ThreadSlotHandle&) = delete;
+		ThreadSlotHandle& operator=(ThreadSlotHandle&&) noexcept = delete;
+
+		int Get() const { return m_Slot; }
+	private:
+		int m_Slot{ NoThreadSlot };
+	};
+
+	//small dense index of the calling thread for per thread slots, handed out on first use,
+	//no two live threads ever share one, NoThreadSlot when they are all taken
+	inline int GetThreadSlot()
+	{
+		thread_local ThreadSlotHandle const threadSlotHandle{};
+		return threadSlotHandle.Get();
+	}
+
+	inline int GetUsedThreadSlots()
+	{
+		return std::min(ThreadSlotCount.load(std::memory_order_relaxed), MaxThreadSlots);
+	}
+
+	template<typename T>
+	void HashCombine(size_t& seed, T const& value)
+	{
+		seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "PerfCounters.h"
+
+#include <atomic>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr int CounterCount{ sdf::PerfSample::CounterCount };
+	constexpr int StageCount{ static_cast<int>(sdf::PerfStage::Count) };
+
+	std::array<int, CounterCount> g_FileDescriptorArr{ -1, -1, -1, -1, -1 };
+	bool g_Available{ false };
+	std::string g_Status{ "not opened" };
+
+	//written by whichever thread traced the frame, read by the gui and the benchmark
+	std::array<std::array<std::atomic<int64_t>, CounterCount>, StageCount> g_StageSampleArr{};
+	std::array<std::atomic<bool>, StageCount> g_StageMeasuredArr{};
+
+#ifdef __linux__
+	int OpenCounter(uint32_t type, uint64_t config)
+	{
+		perf_event_attr attributes{};
+		attributes.size = sizeof(perf_event_attr);
+		attributes.type = type;
+		attributes.config = config;
+		//user space only, so it works with the default paranoid level
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.inherit = 1;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+	}
+
+	int64_t ReadCounter(int fileDescriptor)
+	{
+		//value, time enabled, time running
+		std::array<uint64_t, 3> readArr{};
+		if (read(fileDescriptor, readArr.data(), sizeof(readArr)) != sizeof(readArr))
+		{
+			return -1;
+		}
+
+		//more counters than the cpu has registers get multiplexed, scale up to the time they were enabled
+		auto const [value, enabledTime, runningTime] { readArr };
+		if (runningTime == 0)
+		{
+			return 0;
+		}
+		if (runningTime < enabledTime)
+		{
+			return static_cast<int64_t>(static_cast<double>(value) * enabledTime / runningTime);
+		}
+		return static_cast<int64_t>(value);
+	}
+#endif
+}
+
+float sdf::PerfSample::GetInstructionsPerCycle() const
+{
+	if (not Has(PerfCounter::Cycles) or not Has(PerfCounter::Instructions) or Get(PerfCounter::Cycles) == 0)
+	{
+		return -1.f;
+	}
+	return static_cast<float>(Get(PerfCounter::Instructions)) / Get(PerfCounter::Cycles);
+}
+
+float sdf::PerfSample::GetPerKiloInstruction(PerfCounter counter) const
+{
+	if (not Has(counter) or not Has(PerfCounter::Instructions) or Get(PerfCounter::Instructions) == 0)
+	{
+		return -1.f;
+	}
+	return static_cast<float>(Get(counter)) * 1000.f / Get(PerfCounter::Instructions);
+}
+
+void sdf::PerfCounters::Open()
+{
+	for (std::array<std::atomic<int64_t>, CounterCount>& stageSampleArr : g_StageSampleArr)
+	{
+		for (std::atomic<int64_t>& value : stageSampleArr)
+		{
+			value = -1;
+		}
+	}
+
+#ifdef __linux__
+	constexpr auto cacheConfig
+	{
+		[](uint64_t cache, uint64_t operation, uint64_t result)
+		{
+			return cache | operation << 8 | result << 16;
+		}
+	};
+
+	std::array<std::pair<uint32_t, uint64_t>, CounterCount> const eventArr
+	{
+		std::make_pair(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+		std::make_pair(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+		std::make_pair(PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)),
+		std::make_pair(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+		std::make_pair(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)
+	};
+
+	//virtual machines and some cpus lack single events, the others are still worth having
+	int openedCount{ 0 };
+	int lastError{ 0 };
+	for (int counterIdx{ 0 }; counterIdx < CounterCount; ++counterIdx)
+	{
+		g_FileDescriptorArr[counterIdx] = OpenCounter(eventArr[counterIdx].first, eventArr[counterIdx].second);
+		if (g_FileDescriptorArr[counterIdx] >= 0)
+		{
+			++openedCount;
+		}
+		else
+		{
+			lastError = errno;
+		}
+	}
+
+	g_Available = openedCount > 0;
+	if (openedCount == CounterCount)
+	{
+		g_Status = "all counters open";
+	}
+	else if (g_Available)
+	{
+		g_Status = std::to_string(CounterCount - openedCount) + " counters unsupported";
+	}
+	else
+	{
+		//EACCES or EPERM mostly means perf_event_paranoid is too strict, ENOENT that there is no pmu
+		g_Status = std::string{ "perf_event_open failed: " } + std::strerror(lastError);
+	}
+#else
+	g_Status = "only available on linux";
+#endif
+}
+
+void sdf::PerfCounters::Close()
+{
+#ifdef __linux__
+	for (int& fileDescriptor : g_FileDescriptorArr)
+	{
+		if (fileDescriptor >= 0)
+		{
+			close(fileDescriptor);
+			fileDescriptor = -1;
+		}
+	}
+#endif
+	g_Available = false;
+	g_Status = "closed";
+}
+
+bool sdf::PerfCounters::IsAvailable()
+{
+	return g_Available;
+}
+
+char const* sdf::PerfCounters::GetStatus()
+{
+	return g_Status.c_str();
+}
+
+char const* sdf::PerfCounters::GetCounterName(int counterIdx)
+{
+	static constexpr std::array<char const*, CounterCount> counterNameArr{ "Cycles", "Instructions", "L1D misses", "LLC misses", "Branch misses" };
+	return counterNameArr[counterIdx];
+}
+
+sdf::PerfSample sdf::PerfCounters::ReadTotals()
+{
+	PerfSample sample{};
+#ifdef __linux__
+	for (int counterIdx{ 0 }; counterIdx < CounterCount; ++counterIdx)
+	{
+		if (g_FileDescriptorArr[counterIdx] >= 0)
+		{
+			sample.ValueArr[counterIdx] = ReadCounter(g_FileDescriptorArr[counterIdx]);
+		}
+	}
+#endif
+	return sample;
+}
+
+sdf::PerfSample sdf::PerfCounters::GetStageSample(PerfStage stage)
+{
+	PerfSample sample{};
+	for (int counterIdx{ 0 }; counterIdx < CounterCount; ++counterIdx)
+	{
+		sample.ValueArr[counterIdx] = g_StageSampleArr[static_cast<int>(stage)][counterIdx].load(std::memory_order_relaxed);
+	}
+	return sample;
+}
+
+void sdf::PerfCounters::AddStageSample(PerfStage stage, PerfSample const& sample)
+{
+	int const stageIdx{ static_cast<int>(stage) };
+	//a trace frame replaces the last one, builds add up
+	bool const accumulate{ stage == PerfStage::Build and g_StageMeasuredArr[stageIdx].exchange(true) };
+
+	for (int counterIdx{ 0 }; counterIdx < CounterCount; ++counterIdx)
+	{
+		std::atomic<int64_t>& value{ g_StageSampleArr[stageIdx][counterIdx] };
+		if (accumulate and value.load(std::memory_order_relaxed) >= 0 and sample.ValueArr[counterIdx] >= 0)
+		{
+			value.fetch_add(sample.ValueArr[counterIdx], std::memory_order_relaxed);
+		}
+		else
+		{
+			value.store(sample.ValueArr[counterIdx], std::memory_order_relaxed);
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace sdf
+{
+
+	enum class PerfCounter
+	{
+		Cycles,
+		Instructions,
+		L1DMisses,
+		LLCMisses,
+		BranchMisses,
+		Count
+	};
+
+	enum class PerfStage
+	{
+		Trace,
+		Build,
+		Count
+	};
+
+	struct PerfSample
+	{
+		static constexpr int CounterCount{ static_cast<int>(PerfCounter::Count) };
+
+		//-1 for counters that could not be opened
+		std::array<int64_t, CounterCount> ValueArr{ -1, -1, -1, -1, -1 };
+
+		int64_t Get(PerfCounter counter) const { return ValueArr[static_cast<int>(counter)]; }
+		bool Has(PerfCounter counter) const { return Get(counter) >= 0; }
+		float GetInstructionsPerCycle() const;
+		//misses per thousand instructions, -1 when either counter is missing
+		float GetPerKiloInstruction(PerfCounter counter) const;
+	};
+
+	//hardware counters of the whole process through perf_event_open, only on linux
+	//every thread started after Open inherits its own counters from the kernel, reads sum them up
+	class PerfCounters final
+	{
+	public:
+		PerfCounters() = delete;
+
+		//has to run before the first worker thread exists, threads that are already running are not counted
+		static void Open();
+		static void Close();
+
+		static bool IsAvailable();
+		//why the counters are unavailable, or which ones are missing
+		static char const* GetStatus();
+		static char const* GetCounterName(int counterIdx);
+
+		static PerfSample ReadTotals();
+		//last measured trace frame, and the sum of every build since the start
+		static PerfSample GetStageSample(PerfStage stage);
+		static void AddStageSample(PerfStage stage, PerfSample const& sample);
+	};
+
+	//counts the hardware events of every thread between construction and destruction into a stage
+	//the counters are process wide, whatever the other threads do in the meantime is counted as well
+	class PerfZone final
+	{
+	public:
+		explicit PerfZone(PerfStage stage)
+			: m_Stage{ stage }
+			, m_Available{ PerfCounters::IsAvailable() }
+		{
+			if (m_Available)
+			{
+				m_StartSample = PerfCounters::ReadTotals();
+			}
+		}
+		~PerfZone()
+		{
+			if (m_Available)
+			{
+				PerfSample const endSample{ PerfCounters::ReadTotals() };
+				PerfSample deltaSample{};
+				for (int counterIdx{ 0 }; counterIdx < PerfSample::CounterCount; ++counterIdx)
+				{
+					if (m_StartSample.ValueArr[counterIdx] >= 0 and endSample.ValueArr[counterIdx] >= 0)
+					{
+						deltaSample.ValueArr[counterIdx] = endSample.ValueArr[counterIdx] - m_StartSample.ValueArr[counterIdx];
+					}
+				}
+				PerfCounters::AddStageSample(m_Stage, deltaSample);
+			}
+		}
+
+		PerfZone(const PerfZone&) = delete;
+		PerfZone(PerfZone&&) noexcept = delete;
+		PerfZone& operator=(const PerfZone&) = delete;
+		PerfZone& operator=(PerfZone&&) noexcept = delete;
+	private:
+		PerfStage m_Stage;
+		bool m_Available;
+		PerfSample m_StartSample{};
+	};
+
+}
@@ -0,0 +1,66 @@
+#include "PixelPacking.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//fit of the srgb curve that only needs square roots, std::pow would keep the loop scalar
+	float EncodeSRGB(float linear)
+	{
+		float const root{ std::sqrt(linear) };
+		float const fourthRoot{ std::sqrt(root) };
+		float const eighthRoot{ std::sqrt(fourthRoot) };
+		float const curve{ 0.662002687f * root + 0.684122060f * fourthRoot - 0.323583601f * eighthRoot - 0.0225411470f * linear };
+		return linear <= 0.0031308f ? 12.92f * linear : curve;
+	}
+
+	template<bool EncodeGamma>
+	uint32_t PackPixel(float red, float green, float blue)
+	{
+		//min and max instead of std::clamp, they map onto single vector instructions
+		red = std::min(std::max(red, 0.f), 1.f);
+		green = std::min(std::max(green, 0.f), 1.f);
+		blue = std::min(std::max(blue, 0.f), 1.f);
+
+		if constexpr (EncodeGamma)
+		{
+			red = std::min(EncodeSRGB(red), 1.f);
+			green = std::min(EncodeSRGB(green), 1.f);
+			blue = std::min(EncodeSRGB(blue), 1.f);
+		}
+
+		//truncates like the SDL_MapRGB calls it replaces, so linear images stay bit identical
+		//signed conversions, unsigned ones have no vector instruction before avx512
+		return 0xFF000000
+			| static_cast<uint32_t>(static_cast<int>(red * 255.f)) << 16
+			| static_cast<uint32_t>(static_cast<int>(green * 255.f)) << 8
+			| static_cast<uint32_t>(static_cast<int>(blue * 255.f));
+	}
+
+	//one flat loop over separate channel arrays, the compiler splits it into 8 or 16 wide vectors on its own
+	template<bool EncodeGamma>
+	void PackRange(float const* redPtr, float const* greenPtr, float const* bluePtr, uint32_t count, uint32_t* outputPtr)
+	{
+		for (uint32_t idx{ 0 }; idx < count; ++idx)
+		{
+			outputPtr[idx] = PackPixel<EncodeGamma>(redPtr[idx], greenPtr[idx], bluePtr[idx]);
+		}
+	}
+}
+
+void sdf::PackPixels(ColorBlock const& block, uint32_t firstIdx, uint32_t count, uint32_t* outputPtr, bool encodeSRGB)
+{
+	float const* redPtr{ block.Red.data() + firstIdx };
+	float const* greenPtr{ block.Green.data() + firstIdx };
+	float const* bluePtr{ block.Blue.data() + firstIdx };
+
+	if (encodeSRGB)
+	{
+		PackRange<true>(redPtr, greenPtr, bluePtr, count, outputPtr);
+	}
+	else
+	{
+		PackRange<false>(redPtr, greenPtr, bluePtr, count, outputPtr);
+	}
+}
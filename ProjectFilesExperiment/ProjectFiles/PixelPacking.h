@@ -0,0 +1,30 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "ColorRGB.h"
+
+namespace sdf
+{
+
+	//shaded colors split per channel, so the conversion loop maps straight onto simd lanes
+	struct ColorBlock final
+	{
+		static constexpr uint32_t Capacity{ 256 };
+
+		std::array<float, Capacity> Red{};
+		std::array<float, Capacity> Green{};
+		std::array<float, Capacity> Blue{};
+
+		void Store(uint32_t idx, ColorRGB const& color)
+		{
+			Red[idx] = color.r;
+			Green[idx] = color.g;
+			Blue[idx] = color.b;
+		}
+	};
+
+	//clamps count colors of the block starting at firstIdx and writes them as ARGB8888, gamma encoded when encodeSRGB is set
+	void PackPixels(ColorBlock const& block, uint32_t firstIdx, uint32_t count, uint32_t* outputPtr, bool encodeSRGB);
+
+}
@@ -0,0 +1,251 @@
+#include "PrimitiveProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Misc.h"
+
+bool sdf::PrimitiveProfiler::m_Enabled{ false };
+
+namespace
+{
+	using ObjectCounters = std::array<int64_t, sdf::PrimitiveProfiler::MaxProfiledObjects>;
+	using TypeCounters = std::array<int64_t, sdf::PrimitiveTypeCount>;
+
+	struct alignas(sdf::CacheLineSize) Slot
+	{
+		ObjectCounters ObjectEvaluations{};
+		ObjectCounters ObjectEarlyOuts{};
+		TypeCounters TypeEvaluations{};
+		TypeCounters TypeEarlyOuts{};
+		TypeCounters TypeTime{};
+		TypeCounters TypeSamples{};
+		//not cleared per frame, so the samples keep spreading over the evaluations
+		uint32_t SampleCounter{};
+	};
+
+	std::array<Slot, sdf::MaxThreadSlots> g_SlotArr{};
+
+	std::array<sdf::PrimitiveProfiler::TypeCost, sdf::PrimitiveTypeCount> g_TypeCostArr{};
+	std::array<sdf::PrimitiveProfiler::ObjectCost, sdf::PrimitiveProfiler::MaxProfiledObjects> g_ObjectCostArr{};
+	TypeCounters g_TotalTime{};
+	TypeCounters g_TotalSamples{};
+	std::array<float, sdf::PrimitiveTypeCount> g_LoadedCostArr{ -1.f, -1.f, -1.f, -1.f, -1.f, -1.f, -1.f };
+
+	//two clock reads back to back, taken off every sample since a cheap primitive costs about as much
+	int64_t const g_ClockOverhead
+	{
+		[]()
+		{
+			int64_t minOverhead{ INT64_MAX };
+			for (int sampleIdx{ 0 }; sampleIdx < 1000; ++sampleIdx)
+			{
+				auto const startTime{ std::chrono::high_resolution_clock::now() };
+				auto const endTime{ std::chrono::high_resolution_clock::now() };
+				minOverhead = std::min<int64_t>(minOverhead, std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+			}
+			return minOverhead;
+		}()
+	};
+
+	int ToObjectIdx(int profileID)
+	{
+		return profileID % sdf::PrimitiveProfiler::MaxProfiledObjects;
+	}
+}
+
+void sdf::PrimitiveProfiler::BeginFrame()
+{
+	//slots past the used ones were never written
+	std::for_each(g_SlotArr.begin(), g_SlotArr.begin() + GetUsedThreadSlots(), [](Slot& slot)
+		{
+			uint32_t const sampleCounter{ slot.SampleCounter };
+			slot = Slot{};
+			slot.SampleCounter = sampleCounter;
+		});
+}
+
+void sdf::PrimitiveProfiler::EndFrame()
+{
+	g_TypeCostArr.fill(TypeCost{});
+	g_ObjectCostArr.fill(ObjectCost{});
+
+	std::for_each(g_SlotArr.begin(), g_SlotArr.begin() + GetUsedThreadSlots(), [](Slot const& slot)
+		{
+			for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+			{
+				g_TypeCostArr[typeIdx].Evaluations += slot.TypeEvaluations[typeIdx];
+				g_TypeCostArr[typeIdx].EarlyOuts += slot.TypeEarlyOuts[typeIdx];
+				g_TotalTime[typeIdx] += slot.TypeTime[typeIdx];
+				g_TotalSamples[typeIdx] += slot.TypeSamples[typeIdx];
+			}
+			for (int objectIdx{ 0 }; objectIdx < MaxProfiledObjects; ++objectIdx)
+			{
+				g_ObjectCostArr[objectIdx].Evaluations += slot.ObjectEvaluations[objectIdx];
+				g_ObjectCostArr[objectIdx].EarlyOuts += slot.ObjectEarlyOuts[objectIdx];
+			}
+		});
+
+	for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+	{
+		if (g_TotalSamples[typeIdx] > 0)
+		{
+			g_TypeCostArr[typeIdx].AverageCost = static_cast<float>(g_TotalTime[typeIdx]) / g_TotalSamples[typeIdx];
+		}
+	}
+}
+
+void sdf::PrimitiveProfiler::RecordEarlyOut(int profileID, PrimitiveType type)
+{
+	int const slotIdx{ GetThreadSlot() };
+	if (slotIdx == NoThreadSlot)
+	{
+		return;
+	}
+
+	Slot& slot{ g_SlotArr[slotIdx] };
+	++slot.ObjectEarlyOuts[ToObjectIdx(profileID)];
+	++slot.TypeEarlyOuts[static_cast<int>(type)];
+}
+
+bool sdf::PrimitiveProfiler::RecordEvaluation(int profileID, PrimitiveType type)
+{
+	int const slotIdx{ GetThreadSlot() };
+	if (slotIdx == NoThreadSlot)
+	{
+		return false;
+	}
+
+	Slot& slot{ g_SlotArr[slotIdx] };
+	++slot.ObjectEvaluations[ToObjectIdx(profileID)];
+	++slot.TypeEvaluations[static_cast<int>(type)];
+	return ++slot.SampleCounter % TimingSampleInterval == 0;
+}
+
+void sdf::PrimitiveProfiler::RecordEvaluationTime(PrimitiveType type, int64_t nanoseconds)
+{
+	int const slotIdx{ GetThreadSlot() };
+	if (slotIdx == NoThreadSlot)
+	{
+		return;
+	}
+
+	Slot& slot{ g_SlotArr[slotIdx] };
+	slot.TypeTime[static_cast<int>(type)] += std::max<int64_t>(nanoseconds - g_ClockOverhead, 0);
+	++slot.TypeSamples[static_cast<int>(type)];
+}
+
+sdf::PrimitiveProfiler::TypeCost const& sdf::PrimitiveProfiler::GetTypeCost(PrimitiveType type)
+{
+	return g_TypeCostArr[static_cast<int>(type)];
+}
+
+sdf::PrimitiveProfiler::ObjectCost const& sdf::PrimitiveProfiler::GetObjectCost(int profileID)
+{
+	return g_ObjectCostArr[ToObjectIdx(profileID)];
+}
+
+float sdf::PrimitiveProfiler::GetAverageCost(PrimitiveType type)
+{
+	int const typeIdx{ static_cast<int>(type) };
+	if (g_TypeCostArr[typeIdx].AverageCost >= 0.f)
+	{
+		return g_TypeCostArr[typeIdx].AverageCost;
+	}
+	return g_LoadedCostArr[typeIdx];
+}
+
+bool sdf::PrimitiveProfiler::LoadCosts(std::string const& fileName)
+{
+	std::ifstream fileStream{ fileName };
+	if (not fileStream)
+	{
+		return false;
+	}
+
+	//KIND,NAME,EVALUATIONS,EARLY OUTS,AVG COST NS, the object rows and types without samples are skipped
+	std::string line{};
+	while (std::getline(fileStream, line))
+	{
+		std::stringstream lineStream{ line };
+		std::string kind{};
+		std::string name{};
+		std::string cost{};
+		std::getline(lineStream, kind, ',');
+		std::getline(lineStream, name, ',');
+		for (int skipIdx{ 0 }; skipIdx < 3; ++skipIdx)
+		{
+			std::getline(lineStream, cost, ',');
+		}
+		if (kind != "type" or cost.empty())
+		{
+			continue;
+		}
+
+		for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+		{
+			if (name != GetPrimitiveTypeName(static_cast<PrimitiveType>(typeIdx)))
+			{
+				continue;
+			}
+
+			//a broken file is dropped as a whole, every type then falls back to timing its objects like without one
+			float parsedCost{ -1.f };
+			try
+			{
+				parsedCost = std::stof(cost);
+			}
+			catch (std::logic_error const&)
+			{
+			}
+			if (not (parsedCost > 0.f) or not std::isfinite(parsedCost))
+			{
+				g_LoadedCostArr.fill(-1.f);
+				return false;
+			}
+			g_LoadedCostArr[typeIdx] = parsedCost;
+		}
+	}
+	return true;
+}
+
+bool sdf::PrimitiveProfiler::Export(std::string const& fileName, std::vector<std::unique_ptr<Object>> const& objectUPtrVec)
+{
+	std::ofstream fileStream{ fileName };
+	if (not fileStream)
+	{
+		return false;
+	}
+
+	char constexpr delimiter{ ',' };
+	fileStream << "KIND" << delimiter << "NAME" << delimiter << "EVALUATIONS" << delimiter << "EARLY OUTS" << delimiter << "AVG COST NS\n";
+	for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+	{
+		TypeCost const& typeCost{ g_TypeCostArr[typeIdx] };
+		fileStream << "type" << delimiter << GetPrimitiveTypeName(static_cast<PrimitiveType>(typeIdx)) << delimiter << typeCost.Evaluations << delimiter << typeCost.EarlyOuts << delimiter;
+		if (typeCost.AverageCost >= 0.f)
+		{
+			fileStream << typeCost.AverageCost;
+		}
+		fileStream << "\n";
+	}
+
+	for (size_t objectIdx{ 0 }; objectIdx < objectUPtrVec.size(); ++objectIdx)
+	{
+		Object const& object{ *objectUPtrVec[objectIdx] };
+		ObjectCost const& objectCost{ GetObjectCost(object.GetProfileID()) };
+		TypeCost const& typeCost{ GetTypeCost(object.GetType()) };
+		fileStream << "object " << objectIdx << delimiter << object.GetTypeName() << delimiter << objectCost.Evaluations << delimiter << objectCost.EarlyOuts << delimiter;
+		if (typeCost.AverageCost >= 0.f)
+		{
+			fileStream << typeCost.AverageCost;
+		}
+		fileStream << "\n";
+	}
+
+	return static_cast<bool>(fileStream);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SDFObjects.h"
+
+namespace sdf
+{
+
+	//how often every object and primitive type got evaluated or skipped by its early out, and what an evaluation costs
+	//every thread counts into its own slot, the slots get merged once per frame
+	class PrimitiveProfiler final
+	{
+	public:
+		//objects past this share counters with the ones before them
+		static constexpr int MaxProfiledObjects{ 256 };
+		//one in this many evaluations per thread gets timed
+		static constexpr uint32_t TimingSampleInterval{ 32 };
+
+		struct TypeCost
+		{
+			int64_t Evaluations{};
+			int64_t EarlyOuts{};
+			//nanoseconds per evaluation averaged over every sample since the start, -1 before the first sample
+			float AverageCost{ -1.f };
+		};
+
+		struct ObjectCost
+		{
+			int64_t Evaluations{};
+			int64_t EarlyOuts{};
+		};
+
+		PrimitiveProfiler() = delete;
+
+		static bool m_Enabled;
+
+		static void BeginFrame();
+		static void EndFrame();
+
+		static void RecordEarlyOut(int profileID, PrimitiveType type);
+		//counts the evaluation, true when it should be timed
+		static bool RecordEvaluation(int profileID, PrimitiveType type);
+		static void RecordEvaluationTime(PrimitiveType type, int64_t nanoseconds);
+
+		//counts of the last merged frame
+		static TypeCost const& GetTypeCost(PrimitiveType type);
+		static ObjectCost const& GetObjectCost(int profileID);
+		//measured average of the primitive type, the one of a loaded profile before the first sample, -1 when neither exists
+		static float GetAverageCost(PrimitiveType type);
+		//reads the type rows of an exported csv, false when the file could not be opened or a cost did not parse,
+		//in which case nothing of it is used
+		static bool LoadCosts(std::string const& fileName);
+
+		//csv with a row per primitive type and a row per object of the given scene objects
+		static bool Export(std::string const& fileName, std::vector<std::unique_ptr<Object>> const& objectUPtrVec);
+	};
+
+	//counts a full evaluation and times it when it is one of the samples
+	class PrimitiveEvaluationZone final
+	{
+	public:
+		PrimitiveEvaluationZone(int profileID, PrimitiveType type)
+			: m_Type{ type }
+			, m_Timed{ PrimitiveProfiler::RecordEvaluation(profileID, type) }
+		{
+			if (m_Timed)
+			{
+				m_StartTime = std::chrono::high_resolution_clock::now();
+			}
+		}
+		~PrimitiveEvaluationZone()
+		{
+			if (m_Timed)
+			{
+				PrimitiveProfiler::RecordEvaluationTime(m_Type, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_StartTime).count());
+			}
+		}
+
+		PrimitiveEvaluationZone(const PrimitiveEvaluationZone&) = delete;
+		PrimitiveEvaluationZone(PrimitiveEvaluationZone&&) noexcept = delete;
+		PrimitiveEvaluationZone& operator=(const PrimitiveEvaluationZone&) = delete;
+		PrimitiveEvaluationZone& operator=(PrimitiveEvaluationZone&&) noexcept = delete;
+	private:
+		PrimitiveType m_Type;
+		bool m_Timed;
+		std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTime{};
+	};
+
+}
@@ -0,0 +1,61 @@
+#include "Profiler.h"
+
+#include <algorithm>
+
+void sdf::Profiler::AddStageTime(ProfileStage stage, int64_t nanoseconds)
+{
+	m_CurrentFrameArr[static_cast<int>(stage)].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void sdf::Profiler::EndFrame()
+{
+	float stackedTime{ 0.f };
+	for (int stageIdx{ 0 }; stageIdx < StageCount; ++stageIdx)
+	{
+		float const stageTime{ m_CurrentFrameArr[stageIdx].exchange(0, std::memory_order_relaxed) / 1'000'000.f };
+		stackedTime += stageTime;
+
+		m_StageTimeArr[stageIdx][m_NextFrame] = stageTime;
+		m_StageTimeArr[stageIdx][m_NextFrame + FrameCount] = stageTime;
+		m_StackedTimeArr[stageIdx][m_NextFrame] = stackedTime;
+		m_StackedTimeArr[stageIdx][m_NextFrame + FrameCount] = stackedTime;
+	}
+
+	m_NextFrame = (m_NextFrame + 1) % FrameCount;
+	m_RecordedFrames = std::min(m_RecordedFrames + 1, FrameCount);
+
+	UpdatePercentiles();
+}
+
+char const* sdf::Profiler::GetStageName(int stageIdx)
+{
+	static constexpr std::array<char const*, StageCount> stageNameArr{ "Update", "Trace", "Shade", "Upload", "GUI", "Present" };
+	return stageNameArr[stageIdx];
+}
+
+float sdf::Profiler::GetLastStageTime(int stageIdx) const
+{
+	return m_StageTimeArr[stageIdx][m_NextFrame + FrameCount - 1];
+}
+
+void sdf::Profiler::UpdatePercentiles()
+{
+	std::array<float, FrameCount> sortedArr{};
+	for (int stageIdx{ 0 }; stageIdx < StageCount; ++stageIdx)
+	{
+		//the recorded frames are the newest ones, right before the next frame in the doubled history
+		float const* firstPtr{ m_StageTimeArr[stageIdx].data() + m_NextFrame + FrameCount - m_RecordedFrames };
+		std::copy(firstPtr, firstPtr + m_RecordedFrames, sortedArr.begin());
+		std::sort(sortedArr.begin(), sortedArr.begin() + m_RecordedFrames);
+
+		auto const getPercentile
+		{
+			[&](float percentile)
+			{
+				return sortedArr[static_cast<int>(percentile * (m_RecordedFrames - 1) + 0.5f)];
+			}
+		};
+
+		m_PercentileArr[stageIdx] = StagePercentiles{ getPercentile(0.5f), getPercentile(0.95f), getPercentile(0.99f) };
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "TraceRecorder.h"
+
+namespace sdf
+{
+
+	enum class ProfileStage
+	{
+		Update,
+		Trace,
+		Shade,
+		Upload,
+		GUI,
+		Present,
+		Count
+	};
+
+	//wall time per frame stage, kept for the last FrameCount frames without allocating
+	class Profiler final
+	{
+	public:
+		static constexpr int StageCount{ static_cast<int>(ProfileStage::Count) };
+		static constexpr int FrameCount{ 240 };
+
+		struct StagePercentiles
+		{
+			float P50{};
+			float P95{};
+			float P99{};
+		};
+
+		Profiler() = default;
+		~Profiler() = default;
+
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+		//safe to call from any thread, time of the same stage adds up within a frame
+		void AddStageTime(ProfileStage stage, int64_t nanoseconds);
+		//moves the times of the finished frame into the history, only called by the main thread
+		void EndFrame();
+
+		static char const* GetStageName(int stageIdx);
+		//milliseconds of the stage and every stage before it, oldest frame first, FrameCount values long
+		float const* GetStackedTimes(int stageIdx) const { return m_StackedTimeArr[stageIdx].data() + m_NextFrame; }
+		StagePercentiles const& GetPercentiles(int stageIdx) const { return m_PercentileArr[stageIdx]; }
+		float GetLastStageTime(int stageIdx) const;
+	private:
+		//every frame is written twice, so the last FrameCount frames are always one contiguous range for the plot
+		using History = std::array<float, FrameCount * 2>;
+
+		std::array<std::atomic<int64_t>, StageCount> m_CurrentFrameArr{};
+		std::array<History, StageCount> m_StageTimeArr{};
+		std::array<History, StageCount> m_StackedTimeArr{};
+		std::array<StagePercentiles, StageCount> m_PercentileArr{};
+		int m_NextFrame{ 0 };
+		int m_RecordedFrames{ 0 };
+
+		void UpdatePercentiles();
+	};
+
+	//adds the time between construction and destruction to a stage, and to the trace when one is recorded
+	class ProfileZone final
+	{
+	public:
+		ProfileZone(Profiler& profiler, ProfileStage stage)
+			: m_Profiler{ profiler }
+			, m_Stage{ stage }
+			, m_StartTime{ std::chrono::high_resolution_clock::now() }
+		{
+		}
+		~ProfileZone()
+		{
+			auto const endTime{ std::chrono::high_resolution_clock::now() };
+			m_Profiler.AddStageTime(m_Stage, std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - m_StartTime).count());
+			if (TraceRecorder::m_Enabled)
+			{
+				TraceRecorder::Record(Profiler::GetStageName(static_cast<int>(m_Stage)), m_StartTime, endTime);
+			}
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) noexcept = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(ProfileZone&&) noexcept = delete;
+	private:
+		Profiler& m_Profiler;
+		ProfileStage m_Stage;
+		std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTime;
+	};
+
+}
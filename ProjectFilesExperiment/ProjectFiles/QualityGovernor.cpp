@@ -0,0 +1,82 @@
+#include "QualityGovernor.h"
+
+#include "glm/glm.hpp"
+
+#include "Renderer.h"
+
+void sdf::QualityGovernor::Update(float renderTime)
+{
+	if (not m_Enabled)
+	{
+		RestoreUserQuality();
+		m_AverageRenderTime = renderTime;
+		m_SlowFrameCount = 0;
+		m_FastFrameCount = 0;
+		return;
+	}
+
+	if (not m_UserQualityLevel.has_value())
+	{
+		m_UserQualityLevel = QualityLevel{ Renderer::m_RenderScale, Renderer::m_MaxSteps, Renderer::m_HitDistance };
+	}
+
+	//smooth out single spikes, a stall should not drop the quality on its own
+	m_AverageRenderTime = glm::mix(m_AverageRenderTime, renderTime, 0.2f);
+
+	float const targetFrameTime{ 1.f / glm::max(m_TargetFrameRate, 1.f) };
+
+	if (m_AverageRenderTime > targetFrameTime * m_DowngradeThreshold)
+	{
+		++m_SlowFrameCount;
+		m_FastFrameCount = 0;
+	}
+	else if (m_AverageRenderTime < targetFrameTime * m_UpgradeThreshold)
+	{
+		++m_FastFrameCount;
+		m_SlowFrameCount = 0;
+	}
+	else
+	{
+		m_SlowFrameCount = 0;
+		m_FastFrameCount = 0;
+	}
+
+	int const lastQualityLevel{ static_cast<int>(m_QualityLevelArr.size()) - 1 };
+	if (m_SlowFrameCount >= m_FramesBeforeDowngrade and m_QualityLevel < lastQualityLevel)
+	{
+		++m_QualityLevel;
+		m_SlowFrameCount = 0;
+	}
+	else if (m_FastFrameCount >= m_FramesBeforeUpgrade and m_QualityLevel > 0)
+	{
+		--m_QualityLevel;
+		m_FastFrameCount = 0;
+	}
+
+	ApplyQualityLevel();
+}
+
+void sdf::QualityGovernor::RestoreUserQuality()
+{
+	m_QualityLevel = 0;
+	if (not m_UserQualityLevel.has_value())
+	{
+		return;
+	}
+
+	Renderer::m_RenderScale = m_UserQualityLevel->RenderScale;
+	Renderer::m_MaxSteps = m_UserQualityLevel->MaxSteps;
+	Renderer::m_HitDistance = m_UserQualityLevel->HitDistance;
+	m_UserQualityLevel.reset();
+}
+
+void sdf::QualityGovernor::ApplyQualityLevel() const
+{
+	QualityLevel const& qualityLevel{ m_QualityLevelArr[m_QualityLevel] };
+	QualityLevel const& userQualityLevel{ m_UserQualityLevel.value() };
+
+	//level 0 is exactly what the user had set, the cheaper ones only ever lower it further
+	Renderer::m_RenderScale = glm::min(qualityLevel.RenderScale, userQualityLevel.RenderScale);
+	Renderer::m_MaxSteps = glm::min(qualityLevel.MaxSteps, userQualityLevel.MaxSteps);
+	Renderer::m_HitDistance = glm::max(qualityLevel.HitDistance, userQualityLevel.HitDistance);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <optional>
+
+namespace sdf
+{
+
+	class QualityGovernor final
+	{
+	public:
+		QualityGovernor() = default;
+		~QualityGovernor() = default;
+
+		QualityGovernor(const QualityGovernor&) = delete;
+		QualityGovernor(QualityGovernor&&) noexcept = delete;
+		QualityGovernor& operator=(const QualityGovernor&) = delete;
+		QualityGovernor& operator=(QualityGovernor&&) noexcept = delete;
+
+		//feeds the time the last frame took to trace and adjusts the renderer quality when needed
+		void Update(float renderTime);
+		//puts back the settings the governor started from, done by Update as well once it is disabled
+		void RestoreUserQuality();
+
+		bool& SetEnabled() { return m_Enabled; }
+		float& SetTargetFrameRate() { return m_TargetFrameRate; }
+
+		bool IsEnabled() const { return m_Enabled; }
+		int GetQualityLevel() const { return m_QualityLevel; }
+		float GetAverageRenderTime() const { return m_AverageRenderTime; }
+	private:
+		struct QualityLevel
+		{
+			float RenderScale{};
+			int MaxSteps{};
+			float HitDistance{};
+		};
+
+		//ordered from the best looking to the cheapest, never better than what the user had set
+		static constexpr std::array<QualityLevel, 7> m_QualityLevelArr
+		{
+			QualityLevel{ 1.f, 100000, 0.001f },
+			QualityLevel{ 0.85f, 2000, 0.001f },
+			QualityLevel{ 0.75f, 1000, 0.002f },
+			QualityLevel{ 0.6f, 500, 0.004f },
+			QualityLevel{ 0.5f, 250, 0.008f },
+			QualityLevel{ 0.35f, 150, 0.015f },
+			QualityLevel{ 0.25f, 100, 0.03f }
+		};
+
+		//frame time has to stay out of the band for this many frames, so the level does not flip every frame
+		static constexpr int m_FramesBeforeDowngrade{ 5 };
+		static constexpr int m_FramesBeforeUpgrade{ 30 };
+		static constexpr float m_DowngradeThreshold{ 1.1f };
+		static constexpr float m_UpgradeThreshold{ 0.7f };
+
+		bool m_Enabled{ false };
+		float m_TargetFrameRate{ 30.f };
+
+		int m_QualityLevel{ 0 };
+		//the renderer settings before the governor first changed them, empty while it has not
+		std::optional<QualityLevel> m_UserQualityLevel{};
+		float m_AverageRenderTime{ 0.f };
+		int m_SlowFrameCount{ 0 };
+		int m_FastFrameCount{ 0 };
+
+		void ApplyQualityLevel() const;
+	};
+
+}
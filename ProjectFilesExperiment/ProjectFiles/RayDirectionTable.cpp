@@ -0,0 +1,90 @@
+#include "RayDirectionTable.h"
+
+#include <cmath>
+
+namespace
+{
+	//one flat loop over separate axis arrays, the compiler turns it into a batched matrix multiply
+	//normalized again since the camera basis does not have to be orthonormal
+	void RotateRange(float const* cameraXPtr, float const* cameraYPtr, float const* cameraZPtr, glm::mat3 const& cameraToWorld, uint32_t count,
+		float* __restrict worldXPtr, float* __restrict worldYPtr, float* __restrict worldZPtr)
+	{
+		//plain floats, glm vectors would be reloaded from memory inside the loop
+		float const rightX{ cameraToWorld[0].x };
+		float const rightY{ cameraToWorld[0].y };
+		float const rightZ{ cameraToWorld[0].z };
+		float const upX{ cameraToWorld[1].x };
+		float const upY{ cameraToWorld[1].y };
+		float const upZ{ cameraToWorld[1].z };
+		float const forwardX{ cameraToWorld[2].x };
+		float const forwardY{ cameraToWorld[2].y };
+		float const forwardZ{ cameraToWorld[2].z };
+
+		for (uint32_t idx{ 0 }; idx < count; ++idx)
+		{
+			float const x{ rightX * cameraXPtr[idx] + upX * cameraYPtr[idx] + forwardX * cameraZPtr[idx] };
+			float const y{ rightY * cameraXPtr[idx] + upY * cameraYPtr[idx] + forwardY * cameraZPtr[idx] };
+			float const z{ rightZ * cameraXPtr[idx] + upZ * cameraYPtr[idx] + forwardZ * cameraZPtr[idx] };
+			float const inverseLength{ 1.f / std::sqrt(x * x + y * y + z * z) };
+
+			worldXPtr[idx] = x * inverseLength;
+			worldYPtr[idx] = y * inverseLength;
+			worldZPtr[idx] = z * inverseLength;
+		}
+	}
+}
+
+void sdf::RayDirectionTable::Update(uint32_t width, uint32_t height, float aspectRatio, float fovValue, glm::mat3 const& cameraToWorld)
+{
+	bool const projectionChanged{ width != m_Width or height != m_Height or aspectRatio != m_AspectRatio or fovValue != m_FovValue };
+
+	if (projectionChanged)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_AspectRatio = aspectRatio;
+		m_FovValue = fovValue;
+		BuildCameraDirections();
+	}
+
+	//moving the camera without turning it leaves every direction as it was
+	if (projectionChanged or cameraToWorld != m_CameraToWorld)
+	{
+		m_CameraToWorld = cameraToWorld;
+		RotateDirections();
+	}
+}
+
+void sdf::RayDirectionTable::BuildCameraDirections()
+{
+	uint32_t const nrOfPixels{ m_Width * m_Height };
+
+	m_CameraXVec.resize(nrOfPixels);
+	m_CameraYVec.resize(nrOfPixels);
+	m_CameraZVec.resize(nrOfPixels);
+	m_WorldXVec.resize(nrOfPixels);
+	m_WorldYVec.resize(nrOfPixels);
+	m_WorldZVec.resize(nrOfPixels);
+
+	//same mapping as Renderer::GetCameraDirection through the pixel centers
+	for (uint32_t py{ 0 }; py < m_Height; ++py)
+	{
+		for (uint32_t px{ 0 }; px < m_Width; ++px)
+		{
+			uint32_t const pixelIdx{ py * m_Width + px };
+			float const cx{ (2 * ((px + 0.5f) / m_Width) - 1) * m_AspectRatio * m_FovValue };
+			float const cy{ (1 - (2 * ((py + 0.5f) / m_Height))) * m_FovValue };
+			float const inverseLength{ 1.f / std::sqrt(cx * cx + cy * cy + 1.f) };
+
+			m_CameraXVec[pixelIdx] = cx * inverseLength;
+			m_CameraYVec[pixelIdx] = cy * inverseLength;
+			m_CameraZVec[pixelIdx] = inverseLength;
+		}
+	}
+}
+
+void sdf::RayDirectionTable::RotateDirections()
+{
+	RotateRange(m_CameraXVec.data(), m_CameraYVec.data(), m_CameraZVec.data(), m_CameraToWorld, m_Width * m_Height,
+		m_WorldXVec.data(), m_WorldYVec.data(), m_WorldZVec.data());
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace sdf
+{
+
+	//normalized primary ray direction of every pixel, split per axis so tile and packet tracers can load them as vectors
+	class RayDirectionTable final
+	{
+	public:
+		RayDirectionTable() = default;
+		~RayDirectionTable() = default;
+
+		RayDirectionTable(const RayDirectionTable&) = delete;
+		RayDirectionTable(RayDirectionTable&&) noexcept = delete;
+		RayDirectionTable& operator=(const RayDirectionTable&) = delete;
+		RayDirectionTable& operator=(RayDirectionTable&&) noexcept = delete;
+
+		//rebuilds the camera space directions when the resolution or fov changed and rotates them when the orientation changed
+		void Update(uint32_t width, uint32_t height, float aspectRatio, float fovValue, glm::mat3 const& cameraToWorld);
+
+		glm::vec3 GetDirection(uint32_t pixelIdx) const { return glm::vec3{ m_WorldXVec[pixelIdx], m_WorldYVec[pixelIdx], m_WorldZVec[pixelIdx] }; }
+		float const* GetDirectionsX() const { return m_WorldXVec.data(); }
+		float const* GetDirectionsY() const { return m_WorldYVec.data(); }
+		float const* GetDirectionsZ() const { return m_WorldZVec.data(); }
+	private:
+		uint32_t m_Width{ 0 };
+		uint32_t m_Height{ 0 };
+		float m_AspectRatio{ 0.f };
+		float m_FovValue{ 0.f };
+		glm::mat3 m_CameraToWorld{ 0.f };
+
+		std::vector<float> m_CameraXVec{};
+		std::vector<float> m_CameraYVec{};
+		std::vector<float> m_CameraZVec{};
+
+		std::vector<float> m_WorldXVec{};
+		std::vector<float> m_WorldYVec{};
+		std::vector<float> m_WorldZVec{};
+
+		void BuildCameraDirections();
+		void RotateDirections();
+	};
+
+}
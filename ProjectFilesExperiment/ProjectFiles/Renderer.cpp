@@ -4,6 +4,10 @@
 #include "SDL_surface.h"
 
 #include <numeric>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 
 #include "glm/glm.hpp"
 #include "Scene.h"
@@ -12,32 +16,67 @@
 #include "GUI.h"
 #include "Misc.h"
 #include "Camera.h"
+#include "PixelPacking.h"
+#include "PerfCounters.h"
+#include "PrimitiveProfiler.h"
 
-sdf::Renderer::Renderer(uint32_t const& width, uint32_t const& height)
+bool sdf::Renderer::m_UseStatistics{ true };
+bool sdf::Renderer::m_ProfilePacking{ false };
+
+bool sdf::Renderer::m_UseSRGB{ false };
+bool sdf::Renderer::m_UseTextureLocking{ true };
+
+bool sdf::Renderer::m_UseReprojection{ false };
+float sdf::Renderer::m_ReprojectionSafety{ 0.05f };
+float sdf::Renderer::m_ReprojectionDepthThreshold{ 0.1f };
+
+float sdf::Renderer::m_RenderScale{ 1.f };
+int sdf::Renderer::m_MaxSteps{ 100000 };
+float sdf::Renderer::m_HitDistance{ 0.001f };
+
+bool sdf::Renderer::m_UseCheckerboard{ false };
+float sdf::Renderer::m_CheckerboardMaxMovement{ 0.5f };
+float sdf::Renderer::m_CheckerboardMinAlignment{ 0.995f };
+float sdf::Renderer::m_CheckerboardDepthTolerance{ 0.05f };
+
+bool sdf::Renderer::m_UseAdaptiveSampling{ false };
+float sdf::Renderer::m_AdaptiveDepthThreshold{ 0.05f };
+
+sdf::Renderer::DebugView sdf::Renderer::m_DebugView{ DebugView::None };
+
+bool sdf::Renderer::m_UseAccumulation{ false };
+int sdf::Renderer::m_MaxAccumulatedSamples{ 64 };
+
+sdf::Renderer::Renderer(uint32_t const& width, uint32_t const& height, Profiler& profiler, bool headless)
 	: m_Width{ width }
 	, m_Height{ height }
+	, m_Headless{ headless }
+	, m_Profiler{ profiler }
 {
-	m_WindowPtr = SDL_CreateWindow("SphereTracer, Adriaan Musschoot", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,	width, height, SDL_WINDOW_SHOWN);
-
-	if (m_WindowPtr == nullptr)
+	if (not m_Headless)
 	{
-		throw(std::runtime_error("Window creation failed"));
-	}
+		m_WindowPtr = SDL_CreateWindow("SphereTracer, Adriaan Musschoot", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
 
-	m_RendererPtr = SDL_CreateRenderer(m_WindowPtr, -1, SDL_RENDERER_ACCELERATED);
+		if (m_WindowPtr == nullptr)
+		{
+			throw(std::runtime_error("Window creation failed"));
+		}
 
-	if (m_RendererPtr == nullptr)
-	{
-		throw(std::runtime_error("Renderer creation failed"));
-	}
+		m_RendererPtr = SDL_CreateRenderer(m_WindowPtr, -1, SDL_RENDERER_ACCELERATED);
 
-	m_TexturePtr = SDL_CreateTexture(m_RendererPtr, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+		if (m_RendererPtr == nullptr)
+		{
+			throw(std::runtime_error("Renderer creation failed"));
+		}
 
-	if (m_TexturePtr == nullptr)
-	{
-		throw(std::runtime_error("Texture creation failed"));
+		m_TexturePtr = SDL_CreateTexture(m_RendererPtr, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+
+		if (m_TexturePtr == nullptr)
+		{
+			throw(std::runtime_error("Texture creation failed"));
+		}
 	}
-	
+
 	m_AspectRatio = static_cast<float>(m_Width) / static_cast<float>(m_Height);
 
 	const uint32_t nrOfPixels{ m_Width * m_Height };
@@ -49,15 +88,27 @@ sdf::Renderer::Renderer(uint32_t const& width, uint32_t const& height)
 	}
 
 	m_PixelVec.resize(nrOfPixels);
-	m_HitRecordVec.resize(nrOfPixels);
-
-	m_PixelFormatPtr = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	m_UpscaledPixelVec.resize(nrOfPixels);
+	m_PresentPixelVec.resize(nrOfPixels, 0xFFFFFFFF);
+	m_HitBuffer.Resize(nrOfPixels);
+	m_PreviousHitBuffer.Resize(nrOfPixels);
+	m_ReprojectedSurfaceVec.resize(nrOfPixels);
+	m_AccumulationVec.resize(nrOfPixels);
+	m_PixelTimeVec.resize(nrOfPixels);
 
-	GUI::Initialize(m_WindowPtr, m_RendererPtr);
+	if (not m_Headless)
+	{
+		GUI::Initialize(m_WindowPtr, m_RendererPtr);
+	}
 }
 
 sdf::Renderer::~Renderer()
 {
+	if (m_Headless)
+	{
+		return;
+	}
+
 	GUI::Destroy();
 	SDL_DestroyTexture(m_TexturePtr);
 	SDL_DestroyRenderer(m_RendererPtr);
@@ -67,37 +118,201 @@ sdf::Renderer::~Renderer()
 
 void sdf::Renderer::Render(Scene const& pScene) const
 {
+	TraceFrame(pScene, m_UseTextureLocking);
+
+	ProfileZone const uploadZone{ m_Profiler, ProfileStage::Upload };
+	UploadFrame();
+}
+
+void sdf::Renderer::Accumulate(Scene const& pScene) const
+{
+	AccumulateFrame(pScene, m_UseTextureLocking);
+
+	ProfileZone const uploadZone{ m_Profiler, ProfileStage::Upload };
+	UploadFrame();
+}
+
+void sdf::Renderer::RenderDetached(Scene const& pScene) const
+{
+	TraceFrame(pScene, false);
+
+	ProfileZone const uploadZone{ m_Profiler, ProfileStage::Upload };
+	FinishDetachedFrame();
+}
+
+void sdf::Renderer::AccumulateDetached(Scene const& pScene) const
+{
+	AccumulateFrame(pScene, false);
+
+	ProfileZone const uploadZone{ m_Profiler, ProfileStage::Upload };
+	FinishDetachedFrame();
+}
+
+void sdf::Renderer::SwapDetachedFrame() const
+{
+	std::swap(m_UpscaledPixelVec, m_PresentPixelVec);
+}
+
+void sdf::Renderer::UploadDetachedFrame() const
+{
+	ProfileZone const uploadZone{ m_Profiler, ProfileStage::Upload };
+	SDL_UpdateTexture(m_TexturePtr, nullptr, m_PresentPixelVec.data(), m_Width * sizeof(uint32_t));
+}
+
+void sdf::Renderer::TraceFrame(Scene const& pScene, bool lockTexture) const
+{
+	//the tiled pass shades and packs while tracing, so only the separate shading pass below shows up as its own stage
+	std::optional<ProfileZone> traceZone{ std::in_place, m_Profiler, ProfileStage::Trace };
+	PerfZone const perfZone{ PerfStage::Trace };
+
 	Camera const& camera{ pScene.GetCamera() };
 
 	float const& fovValue{ camera.fovValue };
 	glm::mat3 const& cameraToWorld{ camera.cameraToWorld };
 	glm::vec3 const& origin{ camera.origin };
 
-	std::fill(std::execution::par_unseq, m_PixelVec.begin(), m_PixelVec.end(), SDL_MapRGB(m_PixelFormatPtr, 255, 255, 255));
+	UpdateRenderResolution();
+	m_RayDirectionTable.Update(m_RenderWidth, m_RenderHeight, m_AspectRatio, fovValue, cameraToWorld);
+	AcquireFrameBuffer(lockTexture);
+	m_PackingTime = 0;
+	m_PackingProfiled = m_ProfilePacking;
+
+	m_StatisticsValid = m_UseStatistics;
+	if (m_StatisticsValid)
+	{
+		m_FrameStatistics.Reset();
+	}
+
+	bool const profilePrimitives{ PrimitiveProfiler::m_Enabled };
+	if (profilePrimitives)
+	{
+		PrimitiveProfiler::BeginFrame();
+	}
+
+	FrameView const currentView{ &pScene, pScene.GetVersion(), origin, cameraToWorld, glm::inverse(cameraToWorld), fovValue };
+
+	//history of another scene, changed geometry or another resolution cannot be trusted, neither can hit records that were not stored
+	bool const historyValid{ m_PreviousView.ScenePtr == &pScene and m_PreviousView.SceneVersion == currentView.SceneVersion and m_HitRecordsStored };
+	m_CameraMovement = historyValid ? glm::length(currentView.Origin - m_PreviousView.Origin) : 0.f;
+	m_ReprojectionValid = m_UseReprojection and historyValid;
+
+	std::swap(m_HitBuffer, m_PreviousHitBuffer);
+	if (m_ReprojectionValid)
+	{
+		ReprojectPreviousHits(currentView);
+	}
+
+	//the debug views show the cost of tracing every pixel, not of filling them in
+	bool const useDebugView{ m_DebugView != DebugView::None };
+	bool const useAdaptiveSampling{ m_UseAdaptiveSampling and not useDebugView };
 
-	std::for_each(std::execution::par_unseq, m_PixelIndices.begin(), m_PixelIndices.end(), [&](uint32_t pixelIdx)
+	//after a camera jump the previous frame has little to offer to the missing half
+	bool const useCheckerboard{ m_UseCheckerboard and not useAdaptiveSampling and not useDebugView and historyValid and not IsCameraJump(currentView) };
+	m_CheckerboardParity = useCheckerboard ? 1 - m_CheckerboardParity : 0;
+	bool const viewUnchanged{ historyValid and currentView.Origin == m_PreviousView.Origin and currentView.CameraToWorld == m_PreviousView.CameraToWorld and currentView.FovValue == m_PreviousView.FovValue };
+	//the other half was traced from another view, one more frame from this view completes the image
+	m_CheckerboardPending = useCheckerboard and not viewUnchanged;
+
+	uint32_t const nrOfRenderPixels{ m_RenderWidth * m_RenderHeight };
+
+	if (useAdaptiveSampling or useCheckerboard or useDebugView)
+	{
+		//all of them read back the full hit record buffer, the debug views need its maximum before the first pixel gets a color
+		if (useAdaptiveSampling)
 		{
-			CalculateHitRecords(pScene, fovValue, origin, cameraToWorld, pixelIdx);
-		});
-	
-	std::for_each(std::execution::par_unseq, m_PixelIndices.begin(), m_PixelIndices.end(), [&](uint32_t pixelIdx)
-		{
-			if (HitRecord& hitRecord{ m_HitRecordVec[pixelIdx] }; 
-				hitRecord.DidHit)
-			{
-				//no static white in this case because multithreaded?
-				hitRecord.Shade += (ColorRGB{ 1.f, 1.f, 1.f } * hitRecord.TotalSteps * 0.04f);
-				hitRecord.Shade.MaxToOne();
-				m_PixelVec[pixelIdx] = 
-					SDL_MapRGB
-					(
-						m_PixelFormatPtr, 
-						static_cast<int>(hitRecord.Shade.r * 255), 
-						static_cast<int>(hitRecord.Shade.g * 255), 
-						static_cast<int>(hitRecord.Shade.b * 255)
-					);
-			}
-		});
+			RenderAdaptive(pScene, currentView);
+		}
+		else if (useDebugView)
+		{
+			std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + nrOfRenderPixels, [&](uint32_t pixelIdx)
+				{
+					auto const traceStart{ std::chrono::high_resolution_clock::now() };
+					HitRecord const hitRecord{ TracePixel(pScene, origin, pixelIdx) };
+					std::chrono::nanoseconds const traceTime{ std::chrono::high_resolution_clock::now() - traceStart };
+
+					m_PixelTimeVec[pixelIdx] = static_cast<uint32_t>(std::min<int64_t>(traceTime.count(), UINT32_MAX));
+					m_HitBuffer.Store(pixelIdx, hitRecord);
+					RecordStatistics(hitRecord);
+				});
+		}
+		else
+		{
+			//par since the statistics slots are handed out through an atomic
+			std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + nrOfRenderPixels, [&](uint32_t pixelIdx)
+				{
+					if (IsCheckerboardTraced(pixelIdx))
+					{
+						HitRecord const hitRecord{ TracePixel(pScene, origin, pixelIdx) };
+						m_HitBuffer.Store(pixelIdx, hitRecord);
+						RecordStatistics(hitRecord);
+					}
+				});
+
+			//only reads traced pixels and only writes the others, so it can run in parallel, par since it may trace
+			std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + nrOfRenderPixels, [&](uint32_t pixelIdx)
+				{
+					if (IsCheckerboardTraced(pixelIdx))
+					{
+						return;
+					}
+
+					//the parity alternates, so from the same view the previous frame traced exactly this pixel
+					if (viewUnchanged)
+					{
+						HitRecord const hitRecord{ m_PreviousHitBuffer.Load(pixelIdx) };
+						m_HitBuffer.Store(pixelIdx, hitRecord);
+						RecordStatistics(hitRecord);
+						return;
+					}
+					ReconstructCheckerboardPixel(pScene, pixelIdx, currentView);
+				});
+		}
+		traceZone.reset();
+
+		ProfileZone const shadeZone{ m_Profiler, ProfileStage::Shade };
+		if (useDebugView)
+		{
+			m_DebugMaxValue = GetDebugMaxValue(m_DebugView);
+		}
+
+		//the pixel indices double as row indices
+		std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + m_RenderHeight, [&](uint32_t row)
+			{
+				ColorBlock colorBlock{};
+				for (uint32_t firstColumn{ 0 }; firstColumn < m_RenderWidth; firstColumn += ColorBlock::Capacity)
+				{
+					uint32_t const firstPixelIdx{ row * m_RenderWidth + firstColumn };
+					uint32_t const count{ glm::min(ColorBlock::Capacity, m_RenderWidth - firstColumn) };
+					for (uint32_t columnIdx{ 0 }; columnIdx < count; ++columnIdx)
+					{
+						uint32_t const pixelIdx{ firstPixelIdx + columnIdx };
+						colorBlock.Store(columnIdx, useDebugView ? HeatmapColor(GetDebugValue(m_DebugView, pixelIdx), m_DebugMaxValue) : ShadePixel(m_HitBuffer.LoadShading(pixelIdx), pixelIdx));
+					}
+					PackBlock(colorBlock, 1, count, count, m_FramePtr + row * m_FramePitch + firstColumn, m_FramePitch);
+				}
+			});
+		m_HitRecordsStored = true;
+	}
+	else
+	{
+		//reprojection and the checkerboard need this frame as history next frame, the statistics are counted while tracing
+		bool const storeHitRecords{ m_UseReprojection or m_UseCheckerboard };
+		RenderTiles(pScene, currentView, storeHitRecords);
+		m_HitRecordsStored = storeHitRecords;
+	}
+
+	m_PreviousView = currentView;
+	m_AccumulatedSamples = 1;
+	m_LastPackingTime = m_PackingTime.load() / 1'000'000.f;
+
+	if (m_StatisticsValid)
+	{
+		m_FrameStatistics.Merge();
+	}
+	if (profilePrimitives)
+	{
+		PrimitiveProfiler::EndFrame();
+	}
 	//int old{ Scene::m_BVHSteps };
 	//Scene::m_BVHSteps = 100; 
 	//
@@ -116,16 +331,219 @@ void sdf::Renderer::Render(Scene const& pScene) const
 	//	});
 	//
 	//Scene::m_BVHSteps = old;
+}
+
+void sdf::Renderer::AccumulateFrame(Scene const& pScene, bool lockTexture) const
+{
+	ProfileZone const traceZone{ m_Profiler, ProfileStage::Trace };
+	PerfZone const perfZone{ PerfStage::Trace };
+
+	Camera const& camera{ pScene.GetCamera() };
+
+	AcquireFrameBuffer(lockTexture);
+	//the accumulated frames never report their packing time
+	m_PackingProfiled = false;
+
+	bool const profilePrimitives{ PrimitiveProfiler::m_Enabled };
+	if (profilePrimitives)
+	{
+		PrimitiveProfiler::BeginFrame();
+	}
+
+	//halton points spread the sub pixel samples evenly no matter how many get accumulated
+	glm::vec2 const subPixelOffset{ Halton(m_AccumulatedSamples, 2), Halton(m_AccumulatedSamples, 3) };
+	++m_AccumulatedSamples;
+	float const sampleWeight{ 1.f / m_AccumulatedSamples };
+
+	//the pixel indices double as row indices
+	std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + m_RenderHeight, [&](uint32_t row)
+		{
+			TraceZone const rowZone{ "Accumulate Row", row };
+
+			ColorBlock colorBlock{};
+			for (uint32_t firstColumn{ 0 }; firstColumn < m_RenderWidth; firstColumn += ColorBlock::Capacity)
+			{
+				uint32_t const firstPixelIdx{ row * m_RenderWidth + firstColumn };
+				uint32_t const count{ glm::min(ColorBlock::Capacity, m_RenderWidth - firstColumn) };
+				for (uint32_t columnIdx{ 0 }; columnIdx < count; ++columnIdx)
+				{
+					uint32_t const pixelIdx{ firstPixelIdx + columnIdx };
+					glm::vec3 const cameraDirection{ GetCameraDirection(pixelIdx, camera.fovValue, camera.cameraToWorld, subPixelOffset) };
+					HitRecord const hitRecord{ pScene.GetClosestHit(camera.origin, cameraDirection, m_HitDistance, 1000, m_MaxSteps) };
 
-	SDL_UpdateTexture(m_TexturePtr, nullptr, m_PixelVec.data(), m_Width * sizeof(uint32_t));
-	SDL_RenderClear(m_RendererPtr);
-	SDL_RenderCopy(m_RendererPtr, m_TexturePtr, nullptr, nullptr);
+					ColorRGB& accumulatedShade{ m_AccumulationVec[pixelIdx] };
+					accumulatedShade += ShadeHitRecord(hitRecord);
 
-	GUI::EndFrame();
+					//scalar first, the member operator* would scale the accumulator itself
+					colorBlock.Store(columnIdx, sampleWeight * accumulatedShade);
+				}
+				PackBlock(colorBlock, 1, count, count, m_FramePtr + row * m_FramePitch + firstColumn, m_FramePitch);
+			}
+		});
+	if (profilePrimitives)
+	{
+		PrimitiveProfiler::EndFrame();
+	}
+}
+
+bool sdf::Renderer::IsAccumulating() const
+{
+	return m_UseAccumulation and m_DebugView == DebugView::None and m_AccumulatedSamples < m_MaxAccumulatedSamples;
+}
 
+int sdf::Renderer::GetAccumulatedSamples() const
+{
+	return m_UseAccumulation ? m_AccumulatedSamples : 1;
+}
+
+void sdf::Renderer::Present() const
+{
+	{
+		ProfileZone const presentZone{ m_Profiler, ProfileStage::Present };
+		SDL_RenderClear(m_RendererPtr);
+		SDL_RenderCopy(m_RendererPtr, m_TexturePtr, nullptr, nullptr);
+	}
+	{
+		ProfileZone const guiZone{ m_Profiler, ProfileStage::GUI };
+		GUI::EndFrame();
+	}
+
+	ProfileZone const presentZone{ m_Profiler, ProfileStage::Present };
 	SDL_RenderPresent(m_RendererPtr);
 }
 
+void sdf::Renderer::UpdateRenderResolution() const
+{
+	float const renderScale{ glm::clamp(m_RenderScale, 0.1f, 1.f) };
+	uint32_t const renderWidth{ glm::max(static_cast<uint32_t>(m_Width * renderScale + 0.5f), 1u) };
+	uint32_t const renderHeight{ glm::max(static_cast<uint32_t>(m_Height * renderScale + 0.5f), 1u) };
+
+	if (renderWidth == m_RenderWidth and renderHeight == m_RenderHeight)
+	{
+		return;
+	}
+
+	m_RenderWidth = renderWidth;
+	m_RenderHeight = renderHeight;
+
+	//pixel indices of the history no longer line up
+	m_PreviousView = FrameView{};
+
+	//source texels and 8 bit weights of every window column and row, the window size never changes
+	auto const calculateTaps
+	{
+		[](std::vector<UpscaleTap>& tapVec, uint32_t windowSize, uint32_t renderSize)
+		{
+			tapVec.resize(windowSize);
+			float const ratio{ static_cast<float>(renderSize) / windowSize };
+			for (uint32_t windowIdx{ 0 }; windowIdx < windowSize; ++windowIdx)
+			{
+				float const source{ glm::clamp((windowIdx + 0.5f) * ratio - 0.5f, 0.f, static_cast<float>(renderSize - 1)) };
+				uint32_t const first{ static_cast<uint32_t>(source) };
+				tapVec[windowIdx].First = first;
+				tapVec[windowIdx].Second = glm::min(first + 1, renderSize - 1);
+				tapVec[windowIdx].Weight = static_cast<uint32_t>((source - first) * 256.f + 0.5f);
+			}
+		}
+	};
+
+	calculateTaps(m_UpscaleColumnVec, m_Width, m_RenderWidth);
+	calculateTaps(m_UpscaleRowVec, m_Height, m_RenderHeight);
+}
+
+void sdf::Renderer::AcquireFrameBuffer(bool lockTexture) const
+{
+	bool const nativeResolution{ m_RenderWidth == m_Width and m_RenderHeight == m_Height };
+
+	void* lockedPixelsPtr{ nullptr };
+	int lockedPitch{ 0 };
+	//a failed lock falls back to the copy, some backends hand out a staging buffer that is slower than SDL_UpdateTexture
+	m_TextureLocked = lockTexture and SDL_LockTexture(m_TexturePtr, nullptr, &lockedPixelsPtr, &lockedPitch) == 0;
+	m_LockedPixelsPtr = m_TextureLocked ? static_cast<uint32_t*>(lockedPixelsPtr) : nullptr;
+	m_LockedPitch = static_cast<uint32_t>(lockedPitch) / sizeof(uint32_t);
+
+	//a scaled frame is packed at render resolution first, the upscale then writes into the texture
+	if (m_TextureLocked and nativeResolution)
+	{
+		m_FramePtr = m_LockedPixelsPtr;
+		m_FramePitch = m_LockedPitch;
+	}
+	else
+	{
+		m_FramePtr = m_PixelVec.data();
+		m_FramePitch = m_RenderWidth;
+	}
+}
+
+void sdf::Renderer::UploadFrame() const
+{
+	bool const nativeResolution{ m_RenderWidth == m_Width and m_RenderHeight == m_Height };
+
+	if (m_TextureLocked)
+	{
+		if (not nativeResolution)
+		{
+			Upscale(m_LockedPixelsPtr, m_LockedPitch);
+		}
+		SDL_UnlockTexture(m_TexturePtr);
+		m_TextureLocked = false;
+		return;
+	}
+
+	if (nativeResolution)
+	{
+		SDL_UpdateTexture(m_TexturePtr, nullptr, m_PixelVec.data(), m_Width * sizeof(uint32_t));
+		return;
+	}
+
+	Upscale(m_UpscaledPixelVec.data(), m_Width);
+	SDL_UpdateTexture(m_TexturePtr, nullptr, m_UpscaledPixelVec.data(), m_Width * sizeof(uint32_t));
+}
+
+void sdf::Renderer::FinishDetachedFrame() const
+{
+	//the finished frame always ends up at window resolution, so the main thread only has to copy it into the texture
+	if (m_RenderWidth == m_Width and m_RenderHeight == m_Height)
+	{
+		std::swap(m_PixelVec, m_UpscaledPixelVec);
+		return;
+	}
+
+	Upscale(m_UpscaledPixelVec.data(), m_Width);
+}
+
+void sdf::Renderer::Upscale(uint32_t* outputPtr, uint32_t outputPitch) const
+{
+	//blends two ARGB8888 pixels, red and blue share one multiply and alpha and green the other
+	auto const lerpPixel
+	{
+		[](uint32_t first, uint32_t second, uint32_t weight)
+		{
+			uint32_t const inverseWeight{ 256 - weight };
+			uint32_t const redBlue{ (((first & 0x00FF00FF) * inverseWeight + (second & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF };
+			uint32_t const alphaGreen{ (((first >> 8) & 0x00FF00FF) * inverseWeight + ((second >> 8) & 0x00FF00FF) * weight) & 0xFF00FF00 };
+			return redBlue | alphaGreen;
+		}
+	};
+
+	//the pixel indices double as row indices
+	std::for_each(std::execution::par_unseq, m_PixelIndices.begin(), m_PixelIndices.begin() + m_Height, [&](uint32_t windowRow)
+		{
+			UpscaleTap const& rowTap{ m_UpscaleRowVec[windowRow] };
+			uint32_t const* firstRowPtr{ m_PixelVec.data() + rowTap.First * m_RenderWidth };
+			uint32_t const* secondRowPtr{ m_PixelVec.data() + rowTap.Second * m_RenderWidth };
+			uint32_t* outputRowPtr{ outputPtr + windowRow * outputPitch };
+
+			for (uint32_t windowColumn{ 0 }; windowColumn < m_Width; ++windowColumn)
+			{
+				UpscaleTap const& columnTap{ m_UpscaleColumnVec[windowColumn] };
+				uint32_t const top{ lerpPixel(firstRowPtr[columnTap.First], firstRowPtr[columnTap.Second], columnTap.Weight) };
+				uint32_t const bottom{ lerpPixel(secondRowPtr[columnTap.First], secondRowPtr[columnTap.Second], columnTap.Weight) };
+				outputRowPtr[windowColumn] = lerpPixel(top, bottom, rowTap.Weight);
+			}
+		});
+}
+
 bool sdf::Renderer::SaveBufferToImage(std::string const& imageName) const
 {
 	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, m_Width, m_Height, 32, SDL_PIXELFORMAT_ARGB8888);
@@ -136,59 +554,67 @@ bool sdf::Renderer::SaveBufferToImage(std::string const& imageName) const
 	return result;
 }
 
-sdf::ResultStats sdf::Renderer::GetCollisionStats(bool miss) const
+bool sdf::Renderer::SaveDebugViewsToImages(std::string const& imageName) const
 {
-	ResultStats stats{};
-
-	if (miss)
+	if (m_DebugView == DebugView::None)
 	{
-		std::for_each(std::execution::par_unseq, m_HitRecordVec.begin(), m_HitRecordVec.end(), 
-			[&](HitRecord& hitRecord)
-			{
-				hitRecord.DidHit = not hitRecord.DidHit;
-			});
+		return false;
 	}
 
-	stats.Count = std::count_if(std::execution::par_unseq, m_HitRecordVec.begin(), m_HitRecordVec.end(), 
-		[&](HitRecord const& hitRecord)
-		{ 
-			return hitRecord.DidHit;
-		});
+	//at render resolution and without the gui, every view gets its own ramp maximum
+	static constexpr std::array<char const*, DebugViewCount> fileSuffixArr{ "", "_steps", "_earlyout", "_bvhnodes", "_primitives", "_time" };
 
-	if (stats.Count != 0)
+	bool result{ true };
+	for (int debugViewIdx{ 1 }; debugViewIdx < DebugViewCount; ++debugViewIdx)
 	{
-		stats.AverageStepsThroughScene = std::accumulate(m_HitRecordVec.begin(), m_HitRecordVec.end(), 0,
-			[&](int const& total, HitRecord const& hitRecord)
-			{
-				if (hitRecord.DidHit)
-				{
-					return total + hitRecord.TotalSteps;
-				}
-				return total;
-			}) / stats.Count;
+		DebugView const debugView{ static_cast<DebugView>(debugViewIdx) };
+		uint32_t const maxValue{ GetDebugMaxValue(debugView) };
 
-		stats.AverageBVHDepth = std::accumulate(m_HitRecordVec.begin(), m_HitRecordVec.end(), 0,
-			[&](int const& total, HitRecord const& hitRecord)
-			{
-				if (hitRecord.DidHit)
-				{
-					return total + hitRecord.BVHDepth;
-				}
-				return total;
-			}) / stats.Count;
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, m_RenderWidth, m_RenderHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (surface == nullptr)
+		{
+			return false;
+		}
 
-		stats.AverageEarlyOutSteps = std::accumulate(m_HitRecordVec.begin(), m_HitRecordVec.end(), 0,
-			[&](int const& total, HitRecord const& hitRecord)
+		ColorBlock colorBlock{};
+		for (uint32_t row{ 0 }; row < m_RenderHeight; ++row)
+		{
+			uint32_t* const rowPtr{ reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surface->pixels) + row * surface->pitch) };
+			for (uint32_t firstColumn{ 0 }; firstColumn < m_RenderWidth; firstColumn += ColorBlock::Capacity)
 			{
-				if (hitRecord.DidHit)
+				uint32_t const count{ glm::min(ColorBlock::Capacity, m_RenderWidth - firstColumn) };
+				for (uint32_t columnIdx{ 0 }; columnIdx < count; ++columnIdx)
 				{
-					return total + hitRecord.EarlyOutUsage;
+					colorBlock.Store(columnIdx, HeatmapColor(GetDebugValue(debugView, row * m_RenderWidth + firstColumn + columnIdx), maxValue));
 				}
-				return total;
-			}) / stats.Count;
+				PackPixels(colorBlock, 0, count, rowPtr + firstColumn, m_UseSRGB);
+			}
+		}
+
+		std::string const fullName{ imageName + fileSuffixArr[debugViewIdx] + ".bmp" };
+		result = SDL_SaveBMP(surface, fullName.c_str()) == 0 and result;
+		SDL_FreeSurface(surface);
 	}
+	return result;
+}
+
+sdf::ResultStats sdf::Renderer::GetCollisionStats(bool miss) const
+{
+	//merged at the end of the last traced frame, so asking for them costs nothing
+	if (not m_StatisticsValid)
+	{
+		return ResultStats{};
+	}
+
+	return m_FrameStatistics.GetStats(miss);
+}
 
-	return stats;
+void sdf::Renderer::RecordStatistics(HitRecord const& hitRecord) const
+{
+	if (m_StatisticsValid)
+	{
+		m_FrameStatistics.Record(hitRecord);
+	}
 }
 
 glm::ivec2 sdf::Renderer::GetWindowDimensions() const
@@ -196,6 +622,63 @@ glm::ivec2 sdf::Renderer::GetWindowDimensions() const
 	return glm::ivec2(m_Width, m_Height);
 }
 
+glm::ivec2 sdf::Renderer::GetRenderDimensions() const
+{
+	return glm::ivec2(m_RenderWidth, m_RenderHeight);
+}
+
+sdf::ColorRGB sdf::Renderer::ShadeHitRecord(HitRecord const& hitRecord)
+{
+	if (not hitRecord.DidHit)
+	{
+		return colors::White;
+	}
+
+	ColorRGB shade{ hitRecord.Shade + ColorRGB{ 1.f, 1.f, 1.f } * hitRecord.TotalSteps * 0.04f };
+	shade.MaxToOne();
+	return shade;
+}
+
+void sdf::Renderer::PackBlock(ColorBlock const& colorBlock, uint32_t rowCount, uint32_t rowWidth, uint32_t blockStride, uint32_t* outputPtr, uint32_t outputPitch) const
+{
+	std::chrono::high_resolution_clock::time_point packStart{};
+	if (m_PackingProfiled)
+	{
+		packStart = std::chrono::high_resolution_clock::now();
+	}
+
+	for (uint32_t rowIdx{ 0 }; rowIdx < rowCount; ++rowIdx)
+	{
+		PackPixels(colorBlock, rowIdx * blockStride, rowWidth, outputPtr + rowIdx * outputPitch, m_UseSRGB);
+	}
+
+	if (m_PackingProfiled)
+	{
+		std::chrono::nanoseconds const packTime{ std::chrono::high_resolution_clock::now() - packStart };
+		m_PackingTime.fetch_add(packTime.count(), std::memory_order_relaxed);
+	}
+}
+
+float sdf::Renderer::GetPackingTime() const
+{
+	return m_LastPackingTime;
+}
+
+float sdf::Renderer::Halton(int index, int base)
+{
+	float result{ 0.f };
+	float fraction{ 1.f };
+
+	while (index > 0)
+	{
+		fraction /= base;
+		result += fraction * (index % base);
+		index /= base;
+	}
+
+	return result;
+}
+
 sdf::ColorRGB sdf::Renderer::Palette(float distance)
 {
 	glm::vec3 const a{ 0.5, 0.5, 0.5 };
@@ -203,24 +686,587 @@ sdf::ColorRGB sdf::Renderer::Palette(float distance)
 	glm::vec3 const c{ 1.0, 1.0, 1.0 };
 	glm::vec3 const d{ 0.263f,0.416f,0.457f };
 	
-	glm::vec3 const e{ c * distance + d };
+	//the 2 pi belongs inside the cosine, outside it pushed every channel far past one
+	glm::vec3 const e{ (c * distance + d) * 6.28318f };
 	glm::vec3 const cosE{ std::cos(e.x), std::cos(e.y),  std::cos(e.z) };
-	glm::vec3 const t{ a + cosE * 6.28318f * b };
+	glm::vec3 const t{ a + cosE * b };
 	
 	return ColorRGB{ t.x, t.y, t.z };
 }
 
-void sdf::Renderer::CalculateHitRecords(Scene const& pScene, float fovValue, glm::vec3 const& cameraOrigin, glm::mat3 const& cameraToWorld, uint32_t pixelIdx) const
+sdf::ColorRGB sdf::Renderer::HeatmapColor(uint32_t value, uint32_t maxValue)
+{
+	//between 0.1 and 0.6 the palette only gets brighter, black over blue and cyan to white
+	float const heat{ static_cast<float>(value) / glm::max(maxValue, 1u) };
+	return Palette(0.1f + 0.5f * glm::clamp(heat, 0.f, 1.f));
+}
+
+uint32_t sdf::Renderer::GetDebugValue(DebugView debugView, uint32_t pixelIdx) const
+{
+	switch (debugView)
+	{
+	case DebugView::Steps:
+		return m_HitBuffer.GetSteps()[pixelIdx];
+	case DebugView::EarlyOut:
+		return m_HitBuffer.GetEarlyOuts()[pixelIdx];
+	case DebugView::BVHNodes:
+		return m_HitBuffer.GetBVHNodesVisited()[pixelIdx];
+	case DebugView::PrimitiveEvaluations:
+		return m_HitBuffer.GetPrimitiveEvaluations()[pixelIdx];
+	case DebugView::Time:
+		return m_PixelTimeVec[pixelIdx];
+	default:
+		return 0;
+	}
+}
+
+uint32_t sdf::Renderer::GetDebugMaxValue(DebugView debugView) const
+{
+	return std::transform_reduce(std::execution::par_unseq, m_PixelIndices.begin(), m_PixelIndices.begin() + m_RenderWidth * m_RenderHeight, 1u,
+		[](uint32_t first, uint32_t second) { return glm::max(first, second); },
+		[&](uint32_t pixelIdx) { return GetDebugValue(debugView, pixelIdx); });
+}
+
+char const* sdf::Renderer::GetDebugViewName(int debugViewIdx)
+{
+	static constexpr std::array<char const*, DebugViewCount> debugViewNameArr{ "None", "Steps", "Early Out", "BVH Nodes", "Primitive Evaluations", "Time" };
+	return debugViewNameArr[debugViewIdx];
+}
+
+void sdf::Renderer::CalculateHitRecords(Scene const& pScene, glm::vec3 const& cameraOrigin, uint32_t pixelIdx) const
+{
+	m_HitBuffer.Store(pixelIdx, TracePixel(pScene, cameraOrigin, pixelIdx));
+}
+
+sdf::HitRecord sdf::Renderer::TracePixel(Scene const& pScene, glm::vec3 const& cameraOrigin, uint32_t pixelIdx) const
+{
+	glm::vec3 const cameraDirection{ m_RayDirectionTable.GetDirection(pixelIdx) };
+
+	std::optional<ReprojectedSurface> const reprojectedSurface{ m_ReprojectionValid ? GetReprojectedSurface(pixelIdx) : std::nullopt };
+	//disoccluded, or the reprojected surface lies outside the previous view along this ray, so what is in front of it was never seen
+	if (not reprojectedSurface.has_value() or not ProjectToPixel(cameraOrigin + cameraDirection * reprojectedSurface->Distance, m_PreviousView).has_value())
+	{
+		return pScene.GetClosestHit(cameraOrigin, cameraDirection, m_HitDistance, 1000, m_MaxSteps);
+	}
+
+	//a distance estimator can grow faster than the distance, the margin grows with it the same way its steps shrink
+	float const reprojectedDistance{ reprojectedSurface->Distance };
+	float const safetyMargin{ reprojectedDistance * glm::min(m_ReprojectionSafety / reprojectedSurface->StepScale, 1.f) };
+	float const startDistance{ glm::max(reprojectedDistance - safetyMargin - m_CameraMovement, 0.f) };
+	HitRecord const hitRecord{ pScene.GetClosestHit(cameraOrigin, cameraDirection, m_HitDistance, 1000, m_MaxSteps, startDistance) };
+
+	//a hit on the first step may have started inside the surface, a miss or a hit far from the reprojected distance means
+	//the surface moved or something else took its place, all of them march the full ray again
+	bool const depthChanged{ not hitRecord.DidHit or glm::abs(hitRecord.Distance - reprojectedDistance) > reprojectedDistance * m_ReprojectionDepthThreshold };
+	if (startDistance == 0.f or (hitRecord.TotalSteps != 0 and not depthChanged))
+	{
+		return hitRecord;
+	}
+
+	//the cost views count the discarded march as well
+	HitRecord retracedRecord{ pScene.GetClosestHit(cameraOrigin, cameraDirection, m_HitDistance, 1000, m_MaxSteps) };
+	retracedRecord.TotalSteps += hitRecord.TotalSteps;
+	retracedRecord.EarlyOutUsage += hitRecord.EarlyOutUsage;
+	retracedRecord.BVHNodesVisited += hitRecord.BVHNodesVisited;
+	retracedRecord.PrimitiveEvaluations += hitRecord.PrimitiveEvaluations;
+	return retracedRecord;
+}
+
+void sdf::Renderer::RenderTiles(Scene const& pScene, FrameView const& currentView, bool storeHitRecords) const
+{
+	uint32_t const tileCountX{ (m_RenderWidth + TileSize - 1) / TileSize };
+	uint32_t const tileCountY{ (m_RenderHeight + TileSize - 1) / TileSize };
+
+	static_assert(TileSize * TileSize <= ColorBlock::Capacity);
+
+	//the pixel indices double as tile indices, par since the packing timer is an atomic
+	std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + tileCountX * tileCountY, [&](uint32_t tileIdx)
+		{
+			TraceZone const tileZone{ "Tile", tileIdx };
+
+			uint32_t const minX{ tileIdx % tileCountX * TileSize };
+			uint32_t const minY{ tileIdx / tileCountX * TileSize };
+			uint32_t const maxX{ glm::min(minX + TileSize, m_RenderWidth) };
+			uint32_t const maxY{ glm::min(minY + TileSize, m_RenderHeight) };
+
+			ColorBlock colorBlock{};
+			for (uint32_t y{ minY }; y < maxY; ++y)
+			{
+				for (uint32_t x{ minX }; x < maxX; ++x)
+				{
+					uint32_t const pixelIdx{ y * m_RenderWidth + x };
+					HitRecord const hitRecord{ TracePixel(pScene, currentView.Origin, pixelIdx) };
+
+					if (storeHitRecords)
+					{
+						m_HitBuffer.Store(pixelIdx, hitRecord);
+					}
+					RecordStatistics(hitRecord);
+
+					colorBlock.Store((y - minY) * TileSize + x - minX, ShadePixel(hitRecord, pixelIdx));
+				}
+			}
+
+			PackBlock(colorBlock, maxY - minY, maxX - minX, TileSize, m_FramePtr + minY * m_FramePitch + minX, m_FramePitch);
+		});
+}
+
+sdf::ColorRGB sdf::Renderer::ShadePixel(HitRecord const& hitRecord, uint32_t pixelIdx) const
+{
+	ColorRGB const shade{ ShadeHitRecord(hitRecord) };
+
+	//the centered sample of this frame is the first one of the accumulation
+	if (m_UseAccumulation)
+	{
+		m_AccumulationVec[pixelIdx] = shade;
+	}
+
+	//misses shade to white, so every pixel gets packed and no clear is needed
+	return shade;
+}
+
+void sdf::Renderer::RenderAdaptive(Scene const& pScene, FrameView const& currentView) const
+{
+	//block corners sit on a grid every AdaptiveBlockSize pixels, the last row and column are clamped to the image edge
+	uint32_t const blockCountX{ glm::max((m_RenderWidth - 1 + AdaptiveBlockSize - 1) / AdaptiveBlockSize, 1u) };
+	uint32_t const blockCountY{ glm::max((m_RenderHeight - 1 + AdaptiveBlockSize - 1) / AdaptiveBlockSize, 1u) };
+	uint32_t const cornerCountX{ blockCountX + 1 };
+	uint32_t const cornerCountY{ blockCountY + 1 };
+
+	auto const cornerToPixel
+	{
+		[&](uint32_t cornerX, uint32_t cornerY)
+		{
+			uint32_t const px{ glm::min(cornerX * AdaptiveBlockSize, m_RenderWidth - 1) };
+			uint32_t const py{ glm::min(cornerY * AdaptiveBlockSize, m_RenderHeight - 1) };
+			return glm::uvec2{ px, py };
+		}
+	};
+
+	//the pixel indices double as corner and block indices
+	//every corner is traced and stored here, before any block reads it, the blocks never write them
+	//par, tracing takes locks and thread slots
+	m_AdaptiveCornerConeVec.resize(cornerCountX * cornerCountY);
+	std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + cornerCountX * cornerCountY, [&](uint32_t cornerIdx)
+		{
+			glm::uvec2 const pixel{ cornerToPixel(cornerIdx % cornerCountX, cornerIdx / cornerCountX) };
+			HitRecord const hitRecord{ TracePixel(pScene, currentView.Origin, pixel.y * m_RenderWidth + pixel.x) };
+			m_HitBuffer.Store(pixel.y * m_RenderWidth + pixel.x, hitRecord);
+			m_AdaptiveCornerConeVec[cornerIdx] = hitRecord.ClearConeRatio;
+		});
+
+	//width of a pixel over the distance in the middle of the view, towards the edges pixels cover less
+	float const pixelConeRatio{ 2.f * currentView.FovValue / m_RenderHeight };
+
+	//par since the statistics slots are handed out through an atomic
+	std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + blockCountX * blockCountY, [&](uint32_t blockIdx)
+		{
+			TraceZone const blockZone{ "Adaptive Block", blockIdx };
+
+			uint32_t const blockX{ blockIdx % blockCountX };
+			uint32_t const blockY{ blockIdx / blockCountX };
+			glm::uvec2 const minPixel{ cornerToPixel(blockX, blockY) };
+			glm::uvec2 const maxPixel{ cornerToPixel(blockX + 1, blockY + 1) };
+
+			//local copy of the block including the corners it shares with its neighbours
+			constexpr int localSize{ AdaptiveBlockSize + 1 };
+			enum class SampleState : uint8_t { Empty, Interpolated, Traced };
+			std::array<HitRecord, localSize * localSize> localRecordArr{};
+			std::array<SampleState, localSize * localSize> localStateArr{};
+
+			auto const localIdx{ [](int x, int y) { return y * localSize + x; } };
+			auto const toPixelIdx{ [&](int x, int y) { return (minPixel.y + y) * m_RenderWidth + minPixel.x + x; } };
+
+			auto const traceLocal
+			{
+				[&](int x, int y)
+				{
+					if (localStateArr[localIdx(x, y)] != SampleState::Traced)
+					{
+						localRecordArr[localIdx(x, y)] = TracePixel(pScene, currentView.Origin, toPixelIdx(x, y));
+						localStateArr[localIdx(x, y)] = SampleState::Traced;
+					}
+				}
+			};
+
+			int const width{ static_cast<int>(maxPixel.x - minPixel.x) };
+			int const height{ static_cast<int>(maxPixel.y - minPixel.y) };
+
+			for (glm::ivec2 const corner : { glm::ivec2{ 0, 0 }, glm::ivec2{ width, 0 }, glm::ivec2{ 0, height }, glm::ivec2{ width, height } })
+			{
+				HitRecord& cornerRecord{ localRecordArr[localIdx(corner.x, corner.y)] };
+				cornerRecord = m_HitBuffer.Load(toPixelIdx(corner.x, corner.y));
+				cornerRecord.ClearConeRatio = m_AdaptiveCornerConeVec[(blockY + (corner.y == 0 ? 0 : 1)) * cornerCountX + blockX + (corner.x == 0 ? 0 : 1)];
+				localStateArr[localIdx(corner.x, corner.y)] = SampleState::Traced;
+			}
+
+			auto const subdivide
+			{
+				[&](auto const& self, int minX, int minY, int maxX, int maxY) -> void
+				{
+					//every pixel of the rectangle is a corner
+					if (maxX - minX <= 1 and maxY - minY <= 1)
+					{
+						return;
+					}
+
+					HitRecord const& topLeft{ localRecordArr[localIdx(minX, minY)] };
+					HitRecord const& topRight{ localRecordArr[localIdx(maxX, minY)] };
+					HitRecord const& bottomLeft{ localRecordArr[localIdx(minX, maxY)] };
+					HitRecord const& bottomRight{ localRecordArr[localIdx(maxX, maxY)] };
+
+					//every point of the rectangle is within half its diagonal of a corner ray
+					float const blockConeRatio{ 0.5f * glm::length(glm::vec2{ maxX - minX, maxY - minY }) * pixelConeRatio };
+					if (IsAdaptiveCoherent(topLeft, topRight, bottomLeft, bottomRight, blockConeRatio))
+					{
+						for (int y{ minY }; y <= maxY; ++y)
+						{
+							for (int x{ minX }; x <= maxX; ++x)
+							{
+								if (localStateArr[localIdx(x, y)] != SampleState::Empty)
+								{
+									continue;
+								}
+
+								float const u{ maxX == minX ? 0.f : static_cast<float>(x - minX) / (maxX - minX) };
+								float const v{ maxY == minY ? 0.f : static_cast<float>(y - minY) / (maxY - minY) };
+								auto const blend
+								{
+									[&](auto HitRecord::* member)
+									{
+										float const top{ glm::mix(static_cast<float>(topLeft.*member), static_cast<float>(topRight.*member), u) };
+										float const bottom{ glm::mix(static_cast<float>(bottomLeft.*member), static_cast<float>(bottomRight.*member), u) };
+										return glm::mix(top, bottom, v);
+									}
+								};
+
+								HitRecord& hitRecord{ localRecordArr[localIdx(x, y)] };
+								hitRecord = topLeft;
+								hitRecord.Distance = blend(&HitRecord::Distance);
+								hitRecord.TotalSteps = static_cast<int>(blend(&HitRecord::TotalSteps) + 0.5f);
+								hitRecord.EarlyOutUsage = static_cast<int>(blend(&HitRecord::EarlyOutUsage) + 0.5f);
+								hitRecord.RefinementSteps = static_cast<int>(blend(&HitRecord::RefinementSteps) + 0.5f);
+								hitRecord.BVHDepth = static_cast<int>(blend(&HitRecord::BVHDepth) + 0.5f);
+								localStateArr[localIdx(x, y)] = SampleState::Interpolated;
+							}
+						}
+						return;
+					}
+
+					//split every side that still has pixels in between its corners
+					int const midX{ (minX + maxX) / 2 };
+					int const midY{ (minY + maxY) / 2 };
+					bool const splitX{ maxX - minX > 1 };
+					bool const splitY{ maxY - minY > 1 };
+
+					std::array<int, 3> const xArr{ minX, splitX ? midX : maxX, maxX };
+					std::array<int, 3> const yArr{ minY, splitY ? midY : maxY, maxY };
+					int const xCount{ splitX ? 3 : 2 };
+					int const yCount{ splitY ? 3 : 2 };
+
+					for (int yIdx{ 0 }; yIdx < yCount; ++yIdx)
+					{
+						for (int xIdx{ 0 }; xIdx < xCount; ++xIdx)
+						{
+							traceLocal(xArr[xIdx], yArr[yIdx]);
+						}
+					}
+
+					for (int yIdx{ 0 }; yIdx + 1 < yCount; ++yIdx)
+					{
+						for (int xIdx{ 0 }; xIdx + 1 < xCount; ++xIdx)
+						{
+							self(self, xArr[xIdx], yArr[yIdx], xArr[xIdx + 1], yArr[yIdx + 1]);
+						}
+					}
+				}
+			};
+			subdivide(subdivide, 0, 0, width, height);
+
+			//the right and bottom edge belong to the next block, unless this block touches the image edge
+			//the corners are already stored and read by the neighbouring blocks, so they are only counted
+			int const ownedWidth{ maxPixel.x == m_RenderWidth - 1 ? width + 1 : width };
+			int const ownedHeight{ maxPixel.y == m_RenderHeight - 1 ? height + 1 : height };
+			for (int y{ 0 }; y < ownedHeight; ++y)
+			{
+				for (int x{ 0 }; x < ownedWidth; ++x)
+				{
+					bool const isCorner{ (x == 0 or x == width) and (y == 0 or y == height) };
+					if (not isCorner)
+					{
+						m_HitBuffer.Store(toPixelIdx(x, y), localRecordArr[localIdx(x, y)]);
+					}
+					RecordStatistics(localRecordArr[localIdx(x, y)]);
+				}
+			}
+		});
+}
+
+bool sdf::Renderer::IsAdaptiveCoherent(HitRecord const& topLeft, HitRecord const& topRight, HitRecord const& bottomLeft, HitRecord const& bottomRight, float blockConeRatio)
+{
+	std::array<HitRecord const*, 4> const cornerArr{ &topLeft, &topRight, &bottomLeft, &bottomRight };
+
+	float minDistance{ FLT_MAX };
+	float maxDistance{ 0.f };
+	float minConeRatio{ FLT_MAX };
+	for (HitRecord const* cornerPtr : cornerArr)
+	{
+		if (cornerPtr->DidHit != topLeft.DidHit or cornerPtr->ObjectID != topLeft.ObjectID)
+		{
+			return false;
+		}
+		minDistance = glm::min(minDistance, cornerPtr->Distance);
+		maxDistance = glm::max(maxDistance, cornerPtr->Distance);
+		minConeRatio = glm::min(minConeRatio, cornerPtr->ClearConeRatio);
+	}
+
+	//misses carry no depth worth comparing, but an object smaller than the block can lie in between them,
+	//hits close in on their surface so their cone tells nothing
+	if (not topLeft.DidHit)
+	{
+		return minConeRatio >= blockConeRatio;
+	}
+	return maxDistance - minDistance <= minDistance * m_AdaptiveDepthThreshold;
+}
+
+glm::vec3 sdf::Renderer::GetCameraDirection(uint32_t pixelIdx, float fovValue, glm::mat3 const& cameraToWorld, glm::vec2 const& subPixelOffset) const
+{
+	uint32_t const px{ pixelIdx % m_RenderWidth };
+	uint32_t const py{ pixelIdx / m_RenderWidth };
+
+	float const rx{ px + subPixelOffset.x };
+	float const ry{ py + subPixelOffset.y };
+	float const cx{ (2 * (rx / m_RenderWidth) - 1) * m_AspectRatio * fovValue };
+	float const cy{ (1 - (2 * (ry / m_RenderHeight))) * fovValue };
+
+	return glm::normalize(cameraToWorld * glm::vec3{ cx, cy, 1.f });
+}
+
+void sdf::Renderer::ReprojectPreviousHits(FrameView const& currentView) const
+{
+	std::fill(std::execution::par_unseq, m_ReprojectedSurfaceVec.begin(), m_ReprojectedSurfaceVec.end(), UINT64_MAX);
+
+	//atomics are not allowed in unsequenced execution
+	std::for_each(std::execution::par, m_PixelIndices.begin(), m_PixelIndices.begin() + m_RenderWidth * m_RenderHeight, [&](uint32_t pixelIdx)
+		{
+			if (not m_PreviousHitBuffer.DidHit(pixelIdx))
+			{
+				return;
+			}
+
+			glm::vec3 const hitPoint{ GetPreviousHitPoint(pixelIdx) };
+
+			std::optional<uint32_t> const reprojectedIdx{ ProjectToPixel(hitPoint, currentView) };
+			if (not reprojectedIdx.has_value())
+			{
+				return;
+			}
+
+			float const stepScale{ Object::GetStepScale(currentView.ScenePtr->GetObjects()[m_PreviousHitBuffer.GetObjectIDs()[pixelIdx]]->GetType()) };
+			uint64_t const surfaceBits{ uint64_t{ std::bit_cast<uint32_t>(glm::length(hitPoint - currentView.Origin)) } << 32 | std::bit_cast<uint32_t>(stepScale) };
+
+			std::atomic_ref<uint64_t> reprojectedSurface{ m_ReprojectedSurfaceVec[reprojectedIdx.value()] };
+			uint64_t currentBits{ reprojectedSurface.load(std::memory_order_relaxed) };
+			while (surfaceBits < currentBits and not reprojectedSurface.compare_exchange_weak(currentBits, surfaceBits, std::memory_order_relaxed))
+			{
+			}
+		});
+}
+
+std::optional<uint32_t> sdf::Renderer::ProjectToPixel(glm::vec3 const& worldPoint, FrameView const& view) const
+{
+	glm::vec3 const cameraSpacePoint{ view.WorldToCamera * (worldPoint - view.Origin) };
+
+	if (cameraSpacePoint.z <= 0.f)
+	{
+		return std::nullopt;
+	}
+
+	//inverse of the pixel to camera space mapping in GetCameraDirection
+	float const cx{ cameraSpacePoint.x / cameraSpacePoint.z };
+	float const cy{ cameraSpacePoint.y / cameraSpacePoint.z };
+	float const rx{ (cx / (m_AspectRatio * view.FovValue) + 1) * 0.5f * m_RenderWidth };
+	float const ry{ (1 - cy / view.FovValue) * 0.5f * m_RenderHeight };
+
+	if (rx < 0.f or ry < 0.f or rx >= m_RenderWidth or ry >= m_RenderHeight)
+	{
+		return std::nullopt;
+	}
+
+	return static_cast<uint32_t>(ry) * m_RenderWidth + static_cast<uint32_t>(rx);
+}
+
+glm::vec3 sdf::Renderer::GetPreviousHitPoint(uint32_t pixelIdx) const
+{
+	glm::vec3 const previousDirection{ GetCameraDirection(pixelIdx, m_PreviousView.FovValue, m_PreviousView.CameraToWorld) };
+	return m_PreviousView.Origin + previousDirection * m_PreviousHitBuffer.GetDistance(pixelIdx);
+}
+
+bool sdf::Renderer::IsCameraJump(FrameView const& currentView) const
+{
+	glm::vec3 const previousForward{ glm::normalize(m_PreviousView.CameraToWorld[2]) };
+	glm::vec3 const currentForward{ glm::normalize(currentView.CameraToWorld[2]) };
+
+	return m_CameraMovement > m_CheckerboardMaxMovement or glm::dot(previousForward, currentForward) < m_CheckerboardMinAlignment;
+}
+
+bool sdf::Renderer::IsCheckerboardTraced(uint32_t pixelIdx) const
+{
+	uint32_t const px{ pixelIdx % m_RenderWidth };
+	uint32_t const py{ pixelIdx / m_RenderWidth };
+
+	return ((px + py + m_CheckerboardParity) & 1) == 0;
+}
+
+void sdf::Renderer::ReconstructCheckerboardPixel(Scene const& pScene, uint32_t pixelIdx, FrameView const& currentView) const
 {
-	uint32_t const px{ pixelIdx % m_Width };
-	uint32_t const py{ pixelIdx / m_Width };
+	int const px{ static_cast<int>(pixelIdx % m_RenderWidth) };
+	int const py{ static_cast<int>(pixelIdx / m_RenderWidth) };
 
-	float const rx{ px + 0.5f };
-	float const ry{ py + 0.5f };
-	float const cx{ (2 * (rx / m_Width) - 1) * m_AspectRatio * fovValue };
-	float const cy{ (1 - (2 * (ry / m_Height))) * fovValue };
+	//the direct neighbours are always traced in a checkerboard
+	std::array<HitRecord, 4> neighbourArr{};
+	int neighbourCount{ 0 };
+	int hitCount{ 0 };
+	float hitDistanceSum{ 0.f };
 
-	glm::vec3 const cameraDirection{ glm::normalize(cameraToWorld * glm::vec3{ cx, cy, 1.f }) };
+	auto const addNeighbour
+	{
+		[&](int x, int y)
+		{
+			if (x < 0 or y < 0 or x >= static_cast<int>(m_RenderWidth) or y >= static_cast<int>(m_RenderHeight))
+			{
+				return;
+			}
+
+			HitRecord const& neighbour{ neighbourArr[neighbourCount++] = m_HitBuffer.Load(y * m_RenderWidth + x) };
+			if (neighbour.DidHit)
+			{
+				++hitCount;
+				hitDistanceSum += neighbour.Distance;
+			}
+		}
+	};
+	addNeighbour(px - 1, py);
+	addNeighbour(px + 1, py);
+	addNeighbour(px, py - 1);
+	addNeighbour(px, py + 1);
 
-	m_HitRecordVec[pixelIdx] = pScene.GetClosestHit(cameraOrigin, cameraDirection, 0.001f, 1000, 100000);
+	//a silhouette, an object border or a depth step runs through the pixel, neither the history nor a blend can tell which side it is on
+	float minNeighbourDistance{ FLT_MAX };
+	float maxNeighbourDistance{ 0.f };
+	bool neighboursAgree{ true };
+	for (int neighbourIdx{ 0 }; neighbourIdx < neighbourCount; ++neighbourIdx)
+	{
+		HitRecord const& neighbour{ neighbourArr[neighbourIdx] };
+		neighboursAgree = neighboursAgree and neighbour.DidHit == neighbourArr[0].DidHit and neighbour.ObjectID == neighbourArr[0].ObjectID;
+		if (neighbour.DidHit)
+		{
+			minNeighbourDistance = glm::min(minNeighbourDistance, neighbour.Distance);
+			maxNeighbourDistance = glm::max(maxNeighbourDistance, neighbour.Distance);
+		}
+	}
+	if (not neighboursAgree or (hitCount > 0 and maxNeighbourDistance - minNeighbourDistance > minNeighbourDistance * m_CheckerboardDepthTolerance))
+	{
+		HitRecord const hitRecord{ TracePixel(pScene, currentView.Origin, pixelIdx) };
+		m_HitBuffer.Store(pixelIdx, hitRecord);
+		RecordStatistics(hitRecord);
+		return;
+	}
+
+	bool const majorityHit{ hitCount * 2 > neighbourCount };
+
+	if (majorityHit)
+	{
+		//guess the surface from the neighbours and look where that point was in the previous frame
+		float const averageDistance{ hitDistanceSum / hitCount };
+		glm::vec3 const estimatedPoint{ currentView.Origin + m_RayDirectionTable.GetDirection(pixelIdx) * averageDistance };
+
+		if (std::optional<uint32_t> const previousIdx{ ProjectToPixel(estimatedPoint, m_PreviousView) };
+			previousIdx.has_value())
+		{
+			HitRecord const previousHitRecord{ m_PreviousHitBuffer.Load(previousIdx.value()) };
+			float const previousDistance{ glm::length(GetPreviousHitPoint(previousIdx.value()) - currentView.Origin) };
+
+			//only trust the history when it agrees with what was traced around this pixel this frame
+			bool shadeMatches{ false };
+			for (int neighbourIdx{ 0 }; neighbourIdx < neighbourCount; ++neighbourIdx)
+			{
+				HitRecord const& neighbour{ neighbourArr[neighbourIdx] };
+				if (not neighbour.DidHit)
+				{
+					continue;
+				}
+				shadeMatches = shadeMatches or
+					(neighbour.Shade.r == previousHitRecord.Shade.r and neighbour.Shade.g == previousHitRecord.Shade.g and neighbour.Shade.b == previousHitRecord.Shade.b);
+			}
+
+			float const tolerance{ averageDistance * m_CheckerboardDepthTolerance };
+			if (previousHitRecord.DidHit and shadeMatches and
+				previousDistance >= minNeighbourDistance - tolerance and previousDistance <= maxNeighbourDistance + tolerance)
+			{
+				HitRecord hitRecord{ previousHitRecord };
+				hitRecord.Distance = previousDistance;
+				m_HitBuffer.Store(pixelIdx, hitRecord);
+				RecordStatistics(hitRecord);
+				return;
+			}
+		}
+	}
+
+	//no usable history, blend the neighbours that agree with the majority
+	HitRecord const* closestNeighbourPtr{ nullptr };
+	int matchingCount{ 0 };
+	float distanceSum{ 0.f };
+	int stepSum{ 0 };
+	for (int neighbourIdx{ 0 }; neighbourIdx < neighbourCount; ++neighbourIdx)
+	{
+		HitRecord const& neighbour{ neighbourArr[neighbourIdx] };
+		if (neighbour.DidHit != majorityHit)
+		{
+			continue;
+		}
+
+		++matchingCount;
+		distanceSum += neighbour.Distance;
+		stepSum += neighbour.TotalSteps;
+		if (closestNeighbourPtr == nullptr or neighbour.Distance < closestNeighbourPtr->Distance)
+		{
+			closestNeighbourPtr = &neighbour;
+		}
+	}
+
+	if (closestNeighbourPtr == nullptr)
+	{
+		m_HitBuffer.Store(pixelIdx, HitRecord{});
+		RecordStatistics(HitRecord{});
+		return;
+	}
+
+	HitRecord hitRecord{ *closestNeighbourPtr };
+	hitRecord.Distance = distanceSum / matchingCount;
+	hitRecord.TotalSteps = stepSum / matchingCount;
+	m_HitBuffer.Store(pixelIdx, hitRecord);
+	RecordStatistics(hitRecord);
+}
+
+std::optional<sdf::Renderer::ReprojectedSurface> sdf::Renderer::GetReprojectedSurface(uint32_t pixelIdx) const
+{
+	int const px{ static_cast<int>(pixelIdx % m_RenderWidth) };
+	int const py{ static_cast<int>(pixelIdx / m_RenderWidth) };
+
+	//the closest neighbour covers gaps where the reprojected surface got stretched
+	uint64_t closestBits{ UINT64_MAX };
+	for (int y{ glm::max(py - 1, 0) }; y <= glm::min(py + 1, static_cast<int>(m_RenderHeight) - 1); ++y)
+	{
+		for (int x{ glm::max(px - 1, 0) }; x <= glm::min(px + 1, static_cast<int>(m_RenderWidth) - 1); ++x)
+		{
+			closestBits = glm::min(closestBits, m_ReprojectedSurfaceVec[y * m_RenderWidth + x]);
+		}
+	}
+
+	if (closestBits == UINT64_MAX)
+	{
+		return std::nullopt;
+	}
+	return ReprojectedSurface{ std::bit_cast<float>(static_cast<uint32_t>(closestBits >> 32)), std::bit_cast<float>(static_cast<uint32_t>(closestBits)) };
 }
\ No newline at end of file
@@ -1,38 +1,234 @@
 #include <SDL.h>
 #include <vector>
+#include <optional>
+#include <atomic>
 #include "Scene.h"
 #include "ColorRGB.h"
+#include "RayDirectionTable.h"
+#include "HitBuffer.h"
+#include "FrameStatistics.h"
+#include "Profiler.h"
 
 namespace sdf
 {
 
     struct ResultStats;
+    struct ColorBlock;
 
 	class Renderer final
     {
     public:
-        Renderer(uint32_t const& width, uint32_t const& height);
+        //cost of every pixel on a color ramp instead of the shaded scene
+        enum class DebugView
+        {
+            None,
+            Steps,
+            EarlyOut,
+            BVHNodes,
+            PrimitiveEvaluations,
+            Time,
+            Count
+        };
+        static constexpr int DebugViewCount{ static_cast<int>(DebugView::Count) };
+
+        //a headless renderer opens no window and no gui, only the detached calls and the read backs work on it
+        Renderer(uint32_t const& width, uint32_t const& height, Profiler& profiler, bool headless = false);
         ~Renderer();
 
+        //traces the scene and uploads it to the texture
         void Render(Scene const& pScene) const;
+        //draws the last uploaded frame with the gui on top
+        void Present() const;
+        //adds one jittered sample per pixel to the image of the last Render call
+        void Accumulate(Scene const& pScene) const;
+        bool IsAccumulating() const;
+        bool IsCheckerboardPending() const { return m_CheckerboardPending; }
+        int GetAccumulatedSamples() const;
+
+        //same as Render and Accumulate without touching sdl, so they can run on another thread
+        //the finished frame waits in a back buffer until SwapDetachedFrame, which must not overlap them
+        void RenderDetached(Scene const& pScene) const;
+        void AccumulateDetached(Scene const& pScene) const;
+        void SwapDetachedFrame() const;
+        void UploadDetachedFrame() const;
         bool SaveBufferToImage(std::string const& imageName) const;
+        //one bmp per debug view of the last traced frame, only valid while a debug view is selected
+        bool SaveDebugViewsToImages(std::string const& imageName) const;
+        static char const* GetDebugViewName(int debugViewIdx);
 
 		ResultStats GetCollisionStats(bool miss) const;
 
 		glm::ivec2 GetWindowDimensions() const;
+        glm::ivec2 GetRenderDimensions() const;
+        //hit records of the last traced frame at render resolution, only when that frame stored them
+        bool HasHitRecords() const { return m_HitRecordsStored; }
+        HitBuffer const& GetHitBuffer() const { return m_HitBuffer; }
+        //milliseconds the last Render call spent converting colors to packed pixels, 0 unless packing is profiled
+        float GetPackingTime() const;
+
+        //counts hits, misses and their histograms while tracing
+        static bool m_UseStatistics;
+        //times every packed row or tile, two clock reads and an atomic add that every thread shares
+        static bool m_ProfilePacking;
+
+        static bool m_UseSRGB;
+        //packs straight into the streaming texture instead of copying a cpu side frame into it
+        static bool m_UseTextureLocking;
+
+        static bool m_UseReprojection;
+        static float m_ReprojectionSafety;
+        //a miss or a hit further than this fraction from the reprojected distance marches the ray again from the camera
+        static float m_ReprojectionDepthThreshold;
+
+        static float m_RenderScale;
+        static int m_MaxSteps;
+        static float m_HitDistance;
+
+        static bool m_UseCheckerboard;
+        //above this camera movement or below this alignment of the forward vectors every pixel is traced
+        static float m_CheckerboardMaxMovement;
+        static float m_CheckerboardMinAlignment;
+        //relative depth spread up to which traced neighbours count as one surface, beyond it the missing pixel gets traced
+        static float m_CheckerboardDepthTolerance;
+
+        //traces block corners first and only subdivides blocks whose corners disagree
+        static bool m_UseAdaptiveSampling;
+        static float m_AdaptiveDepthThreshold;
+
+        //traces every pixel and keeps the hit records, so checkerboard, adaptive sampling and accumulation are skipped
+        static DebugView m_DebugView;
+
+        static bool m_UseAccumulation;
+        static int m_MaxAccumulatedSamples;
     private:
-        void CalculateHitRecords(Scene const& pScene, float fovValue, glm::vec3 const& cameraOrigin, glm::mat3 const& cameraToWorld, uint32_t pixelIdx) const;
+        struct FrameView
+        {
+            Scene const* ScenePtr{ nullptr };
+            uint32_t SceneVersion{};
+            glm::vec3 Origin{};
+            glm::mat3 CameraToWorld{};
+            glm::mat3 WorldToCamera{};
+            float FovValue{};
+        };
+        struct ReprojectedSurface
+        {
+            float Distance{};
+            //of the primitive type that was hit, a distance estimator can end a ray on another part of itself from a start this close
+            float StepScale{ 1.f };
+        };
+
+        static constexpr uint32_t AdaptiveBlockSize{ 8 };
+        static constexpr uint32_t TileSize{ 16 };
+
+        struct UpscaleTap
+        {
+            uint32_t First{};
+            uint32_t Second{};
+            uint32_t Weight{};
+        };
+
+        //resizes the traced image when the render scale changed
+        void UpdateRenderResolution() const;
+        void TraceFrame(Scene const& pScene, bool lockTexture) const;
+        void AccumulateFrame(Scene const& pScene, bool lockTexture) const;
+        //points the packing passes at the locked texture or at the cpu side frame
+        void AcquireFrameBuffer(bool lockTexture) const;
+        //brings a detached frame to window resolution in the back buffer
+        void FinishDetachedFrame() const;
+        void UploadFrame() const;
+        //bilinear filter from the render resolution to the window resolution
+        void Upscale(uint32_t* outputPtr, uint32_t outputPitch) const;
+
+        void CalculateHitRecords(Scene const& pScene, glm::vec3 const& cameraOrigin, uint32_t pixelIdx) const;
+        //primary ray through the pixel center, the direction comes from the ray direction table of this frame
+        HitRecord TracePixel(Scene const& pScene, glm::vec3 const& cameraOrigin, uint32_t pixelIdx) const;
+        //traces, shades and packs every tile in one go, the hit records are only written when asked for
+        void RenderTiles(Scene const& pScene, FrameView const& currentView, bool storeHitRecords) const;
+        //counts the final record of a pixel, traced or filled in
+        void RecordStatistics(HitRecord const& hitRecord) const;
+        //shade of the pixel, also starts its accumulation
+        ColorRGB ShadePixel(HitRecord const& hitRecord, uint32_t pixelIdx) const;
+        void RenderAdaptive(Scene const& pScene, FrameView const& currentView) const;
+        //blockConeRatio is the width of the block over the distance, missed corners only agree when nothing came that close to them
+        static bool IsAdaptiveCoherent(HitRecord const& topLeft, HitRecord const& topRight, HitRecord const& bottomLeft, HitRecord const& bottomRight, float blockConeRatio);
+        //only for views other than the current one and for jittered samples, the current view has m_RayDirectionTable
+        glm::vec3 GetCameraDirection(uint32_t pixelIdx, float fovValue, glm::mat3 const& cameraToWorld, glm::vec2 const& subPixelOffset = glm::vec2{ 0.5f, 0.5f }) const;
+        //scatters the hit points of the previous frame into the current view, keeping the closest surface per pixel
+        void ReprojectPreviousHits(FrameView const& currentView) const;
+        //closest surface reprojected onto the pixel and its neighbours, empty when nothing landed around it
+        std::optional<ReprojectedSurface> GetReprojectedSurface(uint32_t pixelIdx) const;
+        //pixel of the render resolution the point lands on, empty when it is outside the view
+        std::optional<uint32_t> ProjectToPixel(glm::vec3 const& worldPoint, FrameView const& view) const;
+        glm::vec3 GetPreviousHitPoint(uint32_t pixelIdx) const;
+
+        bool IsCameraJump(FrameView const& currentView) const;
+        bool IsCheckerboardTraced(uint32_t pixelIdx) const;
+        //fills an untraced pixel after the view changed, from the previous frame when it agrees with its traced neighbours,
+        //from the neighbours otherwise, and traces it when the neighbours disagree on hit, object or depth
+        void ReconstructCheckerboardPixel(Scene const& pScene, uint32_t pixelIdx, FrameView const& currentView) const;
+        static ColorRGB ShadeHitRecord(HitRecord const& hitRecord);
+        //cost of the pixel in the last traced frame, nanoseconds for the time view
+        uint32_t GetDebugValue(DebugView debugView, uint32_t pixelIdx) const;
+        uint32_t GetDebugMaxValue(DebugView debugView) const;
+        static ColorRGB HeatmapColor(uint32_t value, uint32_t maxValue);
+        //packs rowCount rows of rowWidth colors, blockStride and outputPitch are the distances between rows
+        void PackBlock(ColorBlock const& colorBlock, uint32_t rowCount, uint32_t rowWidth, uint32_t blockStride, uint32_t* outputPtr, uint32_t outputPitch) const;
+        static float Halton(int index, int base);
         static ColorRGB Palette(float distance);
 
         uint32_t m_Width;
         uint32_t m_Height;
+        mutable uint32_t m_RenderWidth{ 0 };
+        mutable uint32_t m_RenderHeight{ 0 };
         float m_AspectRatio;
-        SDL_Window* m_WindowPtr;
-        SDL_Renderer* m_RendererPtr;
-        SDL_Texture* m_TexturePtr;
+        bool m_Headless;
+        SDL_Window* m_WindowPtr{ nullptr };
+        SDL_Renderer* m_RendererPtr{ nullptr };
+        SDL_Texture* m_TexturePtr{ nullptr };
+        Profiler& m_Profiler;
         std::vector<uint32_t> m_PixelIndices;
         mutable std::vector<uint32_t> m_PixelVec{};
-		SDL_PixelFormat* m_PixelFormatPtr;
-        mutable std::vector<HitRecord> m_HitRecordVec;
+        mutable RayDirectionTable m_RayDirectionTable{};
+        mutable HitBuffer m_HitBuffer{};
+        mutable bool m_HitRecordsStored{ false };
+
+        mutable HitBuffer m_PreviousHitBuffer{};
+        //nanoseconds the trace of every pixel took, only measured for the debug views
+        mutable std::vector<uint32_t> m_PixelTimeVec{};
+        mutable uint32_t m_DebugMaxValue{ 1 };
+
+        mutable FrameStatistics m_FrameStatistics{};
+        mutable bool m_StatisticsValid{ false };
+        //clear cone of every adaptive block corner, the hit buffer does not keep it
+        mutable std::vector<float> m_AdaptiveCornerConeVec{};
+        //float bits of the reprojected distances above those of the step scales, positive floats order the same as their bits
+        //so the closest surface is the smallest value
+        mutable std::vector<uint64_t> m_ReprojectedSurfaceVec;
+        mutable FrameView m_PreviousView{};
+        mutable bool m_ReprojectionValid{ false };
+        mutable float m_CameraMovement{};
+        mutable uint32_t m_CheckerboardParity{ 0 };
+        mutable bool m_CheckerboardPending{ false };
+
+        mutable std::vector<uint32_t> m_UpscaledPixelVec{};
+        //front buffer of the detached frames, only touched by the thread that presents
+        mutable std::vector<uint32_t> m_PresentPixelVec{};
+
+        //target of the packing passes, pitch in pixels
+        mutable uint32_t* m_FramePtr{ nullptr };
+        mutable uint32_t m_FramePitch{ 0 };
+        mutable bool m_TextureLocked{ false };
+        mutable uint32_t* m_LockedPixelsPtr{ nullptr };
+        mutable uint32_t m_LockedPitch{ 0 };
+        mutable std::vector<UpscaleTap> m_UpscaleColumnVec{};
+        mutable std::vector<UpscaleTap> m_UpscaleRowVec{};
+
+        mutable std::vector<ColorRGB> m_AccumulationVec;
+        mutable int m_AccumulatedSamples{ 0 };
+
+        //nanoseconds, summed over every thread
+        mutable std::atomic<int64_t> m_PackingTime{ 0 };
+        mutable bool m_PackingProfiled{ false };
+        mutable float m_LastPackingTime{ 0.f };
     };
 }
\ No newline at end of file
@@ -4,15 +4,32 @@
 #include <execution>
 #include <optional>
 #include <array>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 
 #include "Misc.h"
+#include "BoundSearch.h"
+#include "TraceRecorder.h"
+#include "PerfCounters.h"
+#include "PrimitiveProfiler.h"
 #include <iostream>
 
 bool sdf::Object::m_UseBoxEarlyOut{ true };
+bool sdf::Object::m_UseStepScale{ true };
+
+namespace
+{
+    std::array<float, sdf::PrimitiveTypeCount> g_StepScaleArr{ 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+}
 
 sdf::Object::Object(glm::vec3 const& origin, sdf::ColorRGB const& color)
     : m_Origin{ origin }, m_Color{ color }
 {
+    static int nextProfileID{ 0 };
+    m_ProfileID = nextProfileID++;
 }
 
 float sdf::Object::GetDistance(glm::vec3 const& point, bool useEarlyOuts, sdf::HitRecord& outHitRecord)
@@ -20,13 +37,26 @@ float sdf::Object::GetDistance(glm::vec3 const& point, bool useEarlyOuts, sdf::H
     if (useEarlyOuts)
     {
         float const earlyOutDistance{ EarlyOutTest(point) };
-        if (earlyOutDistance >= 0.001f)
+        if (earlyOutDistance >= EarlyOutThreshold)
         {
 			++outHitRecord.EarlyOutUsage;
+            if (PrimitiveProfiler::m_Enabled)
+            {
+                PrimitiveProfiler::RecordEarlyOut(m_ProfileID, GetType());
+            }
             return earlyOutDistance;
         }
     }
-    return GetDistanceUnoptimized(point);
+    ++outHitRecord.PrimitiveEvaluations;
+
+    float const stepScale{ m_UseStepScale ? GetStepScale(GetType()) : 1.f };
+    //times the evaluation below until the return
+    std::optional<PrimitiveEvaluationZone> evaluationZone{};
+    if (PrimitiveProfiler::m_Enabled)
+    {
+        evaluationZone.emplace(m_ProfileID, GetType());
+    }
+    return GetDistanceUnoptimized(point) * stepScale;
 }
 
 float sdf::Object::EarlyOutTest(glm::vec3 const& point)
@@ -41,6 +71,9 @@ float sdf::Object::EarlyOutTest(glm::vec3 const& point)
 
 void sdf::Object::FurthestSurfaceConcentricCircles(float initialRadius)
 {
+    TraceZone const boundsZone{ "Bounds Concentric Circles" };
+    PerfZone const perfZone{ PerfStage::Build };
+
     float radius{ initialRadius };
 
     std::mutex closestPointMutex{};
@@ -88,6 +121,9 @@ void sdf::Object::FurthestSurfaceConcentricCircles(float initialRadius)
 
 void sdf::Object::FurthestSurfaceAlongAxis(float initialDistance)
 {
+    TraceZone const boundsZone{ "Bounds Along Axis" };
+    PerfZone const perfZone{ PerfStage::Build };
+
 	std::mutex closestPointMutex{};
 
     static std::array<std::pair<int, glm::vec3>, 6> directionArr
@@ -103,9 +139,11 @@ void sdf::Object::FurthestSurfaceAlongAxis(float initialDistance)
 
     do
     {
-        std::for_each(std::execution::par_unseq, directionArr.begin(), directionArr.end(),
+        //par, the trace zone and the lock must not be interleaved on one thread
+        std::for_each(std::execution::par, directionArr.begin(), directionArr.end(),
             [&](std::pair<int, glm::vec3> const& direction)
             {
+                TraceZone const directionZone{ "Bounds Direction", direction.first };
                 {
 					std::lock_guard<std::mutex> lock(closestPointMutex);
 				    if (pointArr[direction.first].has_value())
@@ -179,6 +217,52 @@ void sdf::Object::FurthestSurfaceAlongAxis(float initialDistance)
 		});
 }
 
+void sdf::Object::PadBoundsToSurface()
+{
+    TraceZone const boundsZone{ "Bounds Padding" };
+    PerfZone const perfZone{ PerfStage::Build };
+
+    constexpr int uniformSampleCount{ 4096 };
+    constexpr int refinedSampleCount{ 16 };
+    constexpr int refinementStepCount{ 32 };
+    //the search can miss the very worst point, a small part of the radius on top covers it
+    constexpr float paddingMargin{ 0.01f };
+
+    //bound distance minus surface distance, only where the early out would be taken
+    auto const findWorstOvershoot
+    {
+        [this](auto const& getBound)
+        {
+            return FindWorstBoundExcess(glm::vec3{ 0.f, 0.f, 0.f }, 2.f * m_EarlyOutRadius, uniformSampleCount, refinedSampleCount, refinementStepCount,
+                static_cast<uint32_t>(m_ProfileID), [&](glm::vec3 const& point)
+                {
+                    float const boundDistance{ getBound(point) };
+                    return boundDistance < EarlyOutThreshold ? -FLT_MAX : boundDistance - GetDistanceUnoptimized(point);
+                }).Excess;
+        }
+    };
+
+    //growing every side of the box by the same amount lowers its distance at least that much everywhere outside it
+    float const padding{ paddingMargin * m_EarlyOutRadius };
+    if (float const sphereOvershoot{ findWorstOvershoot([this](glm::vec3 const& point) { return glm::length(point) - m_EarlyOutRadius; }) };
+        sphereOvershoot > 0.f)
+    {
+        m_EarlyOutRadius += sphereOvershoot + padding;
+    }
+    if (float const boxOvershoot
+        {
+            findWorstOvershoot([this](glm::vec3 const& point)
+                {
+                    glm::vec3 const q{ glm::abs(point) - m_BoxExtent };
+                    return glm::length(glm::max(q, 0.0f)) + glm::min(glm::max(q.x, glm::max(q.y, q.z)), 0.0f);
+                })
+        };
+        boxOvershoot > 0.f)
+    {
+        m_BoxExtent += glm::vec3{ boxOvershoot + padding };
+    }
+}
+
 glm::vec3 const& sdf::Object::Origin() const
 {
     return m_Origin;
@@ -194,6 +278,115 @@ float sdf::Object::GetEarlyOutRadius() const
     return m_EarlyOutRadius;
 }
 
+float sdf::Object::GetEvaluationCost()
+{
+    if (m_EvaluationCost >= 0.f)
+    {
+        return m_EvaluationCost;
+    }
+
+    //points in the early out sphere, where the tracer actually evaluates the object
+    constexpr int sampleCount{ 1024 };
+    std::mt19937 generator{ static_cast<uint32_t>(m_ProfileID) };
+    std::uniform_real_distribution<float> distribution{ -1.f, 1.f };
+    std::vector<glm::vec3> pointVec(sampleCount);
+    std::generate(pointVec.begin(), pointVec.end(), [&]()
+        {
+            return glm::vec3{ distribution(generator), distribution(generator), distribution(generator) } * m_EarlyOutRadius;
+        });
+
+    float distanceSum{ 0.f };
+    auto const startTime{ std::chrono::high_resolution_clock::now() };
+    for (glm::vec3 const& point : pointVec)
+    {
+        distanceSum += GetDistanceUnoptimized(point);
+    }
+    std::chrono::duration<float, std::nano> const totalTime{ std::chrono::high_resolution_clock::now() - startTime };
+
+    //written out so the evaluations can not be optimized away
+    volatile float const distanceSink{ distanceSum };
+    static_cast<void>(distanceSink);
+
+    m_EvaluationCost = totalTime.count() / sampleCount;
+    return m_EvaluationCost;
+}
+
+float sdf::Object::GetStepScale(PrimitiveType type)
+{
+    return g_StepScaleArr[static_cast<int>(type)];
+}
+
+void sdf::Object::SetStepScale(PrimitiveType type, float stepScale)
+{
+    g_StepScaleArr[static_cast<int>(type)] = stepScale;
+}
+
+bool sdf::Object::SaveStepScales(std::string const& fileName)
+{
+    std::ofstream fileStream{ fileName };
+    if (not fileStream)
+    {
+        return false;
+    }
+
+    char constexpr delimiter{ ',' };
+    fileStream << "TYPE" << delimiter << "STEP SCALE\n";
+    for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+    {
+        fileStream << GetPrimitiveTypeName(static_cast<PrimitiveType>(typeIdx)) << delimiter << g_StepScaleArr[typeIdx] << "\n";
+    }
+    return static_cast<bool>(fileStream);
+}
+
+bool sdf::Object::LoadStepScales(std::string const& fileName)
+{
+    std::ifstream fileStream{ fileName };
+    if (not fileStream)
+    {
+        return false;
+    }
+
+    //the header and unknown types match no type name and get skipped
+    std::string line{};
+    while (std::getline(fileStream, line))
+    {
+        std::stringstream lineStream{ line };
+        std::string name{};
+        std::string stepScale{};
+        std::getline(lineStream, name, ',');
+        std::getline(lineStream, stepScale, ',');
+
+        for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+        {
+            if (name == GetPrimitiveTypeName(static_cast<PrimitiveType>(typeIdx)) and not stepScale.empty())
+            {
+                //a broken or out of range value falls back to the unscaled step instead of aborting the start
+                try
+                {
+                    float const parsedScale{ std::stof(stepScale) };
+                    g_StepScaleArr[typeIdx] = parsedScale > 0.f and parsedScale <= 1.f ? parsedScale : 1.f;
+                }
+                catch (std::logic_error const&)
+                {
+                    g_StepScaleArr[typeIdx] = 1.f;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+char const* sdf::Object::GetTypeName() const
+{
+    return GetPrimitiveTypeName(GetType());
+}
+
+char const* sdf::GetPrimitiveTypeName(PrimitiveType type)
+{
+    static constexpr std::array<char const*, PrimitiveTypeCount> typeNameArr{ "Sphere", "Link", "Octahedron", "BoxFrame", "HexagonalPrism", "Pyramid", "MandelBulb" };
+    return typeNameArr[static_cast<int>(type)];
+}
+
 sdf::Sphere::Sphere(float radius, glm::vec3 const& origin, sdf::ColorRGB const& color)
     : Object(origin, color)
     , m_Radius{ radius }
@@ -213,6 +406,7 @@ sdf::Link::Link(float height, float innerRadius, float tubeRadius, glm::vec3 con
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::Link::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -230,6 +424,7 @@ sdf::Octahedron::Octahedron(float size, glm::vec3 const& origin, sdf::ColorRGB c
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::Octahedron::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -270,6 +465,7 @@ sdf::BoxFrame::BoxFrame(glm::vec3 const& boxExtent, float roundedValue, glm::vec
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::BoxFrame::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -289,6 +485,7 @@ sdf::HexagonalPrism::HexagonalPrism(float depth, float radius, glm::vec3 const&
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::HexagonalPrism::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -321,6 +518,7 @@ sdf::Pyramid::Pyramid(float height, glm::vec3 const& origin, sdf::ColorRGB const
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::Pyramid::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -359,6 +557,7 @@ sdf::MandelBulb::MandelBulb(glm::vec3 const& origin, sdf::ColorRGB const& color)
 {
 	FurthestSurfaceAlongAxis();
     FurthestSurfaceConcentricCircles();
+    PadBoundsToSurface();
 }
 
 float sdf::MandelBulb::GetDistanceUnoptimized(glm::vec3 const& point)
@@ -1,6 +1,7 @@
 #pragma once
 #include "glm/glm.hpp"
 
+#include <string>
 #include <vector>
 
 #include "ColorRGB.h"
@@ -9,6 +10,20 @@ namespace sdf
 {
     struct HitRecord;
 
+    enum class PrimitiveType
+    {
+        Sphere,
+        Link,
+        Octahedron,
+        BoxFrame,
+        HexagonalPrism,
+        Pyramid,
+        MandelBulb,
+        Count
+    };
+    constexpr int PrimitiveTypeCount{ static_cast<int>(PrimitiveType::Count) };
+    char const* GetPrimitiveTypeName(PrimitiveType type);
+
     class Object
     {
     public:
@@ -21,13 +36,35 @@ namespace sdf
         ColorRGB const& Shade() const;
 
         float GetEarlyOutRadius() const;
+        //early out distances below this evaluate the object, so a bound only has to hold beyond it
+        static constexpr float EarlyOutThreshold{ 0.001f };
+
+        virtual PrimitiveType GetType() const = 0;
+        char const* GetTypeName() const;
+        //unique over every scene, indexes the per object evaluation counters
+        int GetProfileID() const { return m_ProfileID; }
+        //nanoseconds per full evaluation, timed over points around the object the first time it is asked for
+        float GetEvaluationCost();
 
         static bool m_UseBoxEarlyOut;
+        //scales every full evaluation by the step scale of its primitive type, on from the start since every scale
+        //stays 1 until a file loads or --validate estimates them
+        static bool m_UseStepScale;
+        //1 for exact distances, below 1 for distance estimators that grow faster than the distance itself
+        static float GetStepScale(PrimitiveType type);
+        static void SetStepScale(PrimitiveType type, float stepScale);
+        //csv with a row per primitive type, written by the lipschitz estimate of --validate --step-scales <file>
+        static bool SaveStepScales(std::string const& fileName);
+        //values that do not parse or lie outside (0, 1] load as 1
+        static bool LoadStepScales(std::string const& fileName);
     protected:
         virtual float GetDistanceUnoptimized(glm::vec3 const& point) = 0;
 
         void FurthestSurfaceConcentricCircles(float initialRadius = 10);
 		void FurthestSurfaceAlongAxis(float initialDistance = 10);
+        //the searches above only find the surface along rays and axes, grows both bounds by the worst overshoot
+        //of the distance function sampled around them, so they never return more than it
+        void PadBoundsToSurface();
     private:
         glm::vec3 m_Origin{ 0.f, 0.f, 0.f };
         float m_EarlyOutRadius{};
@@ -35,6 +72,8 @@ namespace sdf
         glm::vec3 m_BoxExtent{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
         ColorRGB m_Color{ 1.f, 0.f, 0.f };
+        int m_ProfileID;
+        float m_EvaluationCost{ -1.f };
 
         float EarlyOutTest(glm::vec3 const& point);
     };
@@ -45,6 +84,7 @@ namespace sdf
         Sphere(float radius = 0.3f, glm::vec3 const& origin = glm::vec3{ 0.0f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~Sphere() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::Sphere; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_Radius{};
@@ -56,6 +96,7 @@ namespace sdf
         Link(float height = 0.2f, float innerRadius = 0.2f, float tubeRadius = 0.07f, glm::vec3 const& origin = glm::vec3{ 1.f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~Link() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::Link; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_HeightEmptySpace{ 0.2f };
@@ -69,6 +110,7 @@ namespace sdf
         Octahedron(float size = 0.3f, glm::vec3 const& origin = glm::vec3{ -1.f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~Octahedron() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::Octahedron; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_Size{ 0.3f };
@@ -80,6 +122,7 @@ namespace sdf
         BoxFrame(glm::vec3 const& boxExtent = glm::vec3{ 0.3f, 0.3f, 0.3f }, float roundedValue = 0.02f, glm::vec3 const& origin = glm::vec3{ 1.f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~BoxFrame() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::BoxFrame; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         glm::vec3 m_BoxExtent{};
@@ -92,6 +135,7 @@ namespace sdf
         HexagonalPrism(float depth = 0.2f, float radius = 0.3f, glm::vec3 const& origin = glm::vec3{ -1.f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~HexagonalPrism() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::HexagonalPrism; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_Depth{ 0.2f };
@@ -104,6 +148,7 @@ namespace sdf
         Pyramid(float height = 1.f, glm::vec3 const& origin = glm::vec3{ -0.f, 0.f, 0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~Pyramid() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::Pyramid; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_Height{ 1.f };
@@ -115,6 +160,7 @@ namespace sdf
         MandelBulb(glm::vec3 const& origin = glm::vec3{ 0.f, 0.f, -0.f }, ColorRGB const& color = ColorRGB{ 1.f, 0.f, 0.f });
         virtual ~MandelBulb() = default;
 
+        PrimitiveType GetType() const override { return PrimitiveType::MandelBulb; }
         float GetDistanceUnoptimized(glm::vec3 const& point) override;
     private:
         float m_Radius{ 1.0f };
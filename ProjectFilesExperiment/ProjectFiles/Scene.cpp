@@ -8,6 +8,8 @@
 
 #include "SDFObjects.h"
 #include "BVHNode.h"
+#include "TraceRecorder.h"
+#include "PerfCounters.h"
 
 
 namespace sdf
@@ -16,6 +18,14 @@ namespace sdf
 
 	bool Scene::m_UseBVH{ false };
 
+	bool Scene::m_UseBoundJumps{ false };
+
+	bool Scene::m_UseHitRefinement{ false };
+	float Scene::m_RefinementHitDistance{ 0.01f };
+
+	constexpr int MaxBracketSteps{ 4 };
+	constexpr int MaxRefinementSteps{ 8 };
+
 	//int Scene::m_BVHSteps{ 5 };
 
 	//needs to be defaulted here, because it needs the full definition of the unique_ptr and vector
@@ -25,51 +35,217 @@ namespace sdf
 	//Camera Scene::m_Camera{ glm::vec3{ 0, 0, -5 }, 90, glm::vec3{ 0, 0, 1 } };
 	Camera Scene::m_Camera{ glm::vec3{ 3, 2, 8 }, 90, glm::vec3{ -0.35, -0.2, -1 } };
 
-	HitRecord Scene::GetClosestHit(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps) const
+	HitRecord Scene::GetClosestHit(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps, float startDistance) const
 	{
-		HitRecord hitRecord{};
-		float currentDistance{ 0.f };
+		if (m_UseBVH and m_UseBoundJumps and m_BVHRoot)
+		{
+			return GetClosestHitBoundJumps(origin, direction, minDistance, maxDistance, maxSteps, startDistance);
+		}
 
-		glm::vec3 const origin1{ origin.x, origin.y, origin.z };
-		glm::vec3 const direction1{ direction.x, direction.y, direction.z };
+		HitRecord hitRecord{};
+		float currentDistance{ startDistance };
+		float hitDistance{ m_UseHitRefinement ? glm::max(minDistance, m_RefinementHitDistance) : minDistance };
 
 		int currentStep{ 0 };
 		for (currentStep; currentStep < maxSteps; ++currentStep)
 		{
-			glm::vec3 const newPoint{ origin1 + direction1 * currentDistance };
-			// const float sinDist{ std::sin(currentDistance * 0.3f) };
-			// const float sinTime{ std::sin(m_TotalTime * 0.4f) };
-			// newPoint = Matrix::CreateRotationZ(currentDistance * sinTime * 0.14).TransformPoint(newPoint);
-			// newPoint += Vector3{ 0.f, sinDist * sinTime * 10, 0.f } * 0.3f;
-			const auto[distanceAbleToTravel, object]{ GetDistanceToScene(newPoint, hitRecord) };
-			currentDistance += distanceAbleToTravel;
-
-			if (distanceAbleToTravel < minDistance)
-			{
-				hitRecord.DidHit = true;
-				if (object)
-				{
-					hitRecord.Shade = object->Shade();
-				}
+			if (MarchStep(origin, direction, minDistance, currentDistance, hitDistance, hitRecord) or currentDistance > maxDistance)
+			{
 				break;
 			}
+		}
+
+		hitRecord.Distance = currentDistance;
+		hitRecord.TotalSteps = currentStep;
+		if (currentStep != 0)
+		{
+			hitRecord.BVHDepth /= currentStep;
+			hitRecord.EarlyOutUsage;
+		}
+
+		return hitRecord;
+	}
+
+	HitRecord Scene::GetClosestHitBoundJumps(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps, float startDistance) const
+	{
+		HitRecord hitRecord{};
+
+		//avoid inf * 0 in the slab test for axis aligned rays
+		glm::vec3 const inverseDirection
+		{
+			1.f / (glm::abs(direction.x) > FLT_EPSILON ? direction.x : FLT_EPSILON),
+			1.f / (glm::abs(direction.y) > FLT_EPSILON ? direction.y : FLT_EPSILON),
+			1.f / (glm::abs(direction.z) > FLT_EPSILON ? direction.z : FLT_EPSILON)
+		};
+
+		//reused per thread so tracing a pixel does not allocate, already sorted and merged so every interval is traced only once
+		thread_local std::vector<std::pair<float, float>> intervalVec{};
+		intervalVec.clear();
+		m_BVHRoot->GetRayIntervals(origin, direction, inverseDirection, maxDistance, intervalVec);
+
+		float currentDistance{ startDistance };
+		float hitDistance{ m_UseHitRefinement ? glm::max(minDistance, m_RefinementHitDistance) : minDistance };
+		int currentStep{ 0 };
+		size_t intervalIdx{ 0 };
+
+		while (currentStep < maxSteps and intervalIdx < intervalVec.size())
+		{
+			auto const& [enterDistance, exitDistance] { intervalVec[intervalIdx] };
+
+			//left the bound without hitting anything, move on to the next one
+			if (currentDistance > exitDistance)
+			{
+				++intervalIdx;
+				continue;
+			}
+
+			//the leaf bounds are built from early out radii padded by the overshoot measured around them
+			//(Object::PadBoundsToSurface) plus the bound margin, so the jump to the entry point skips no surface
+			currentDistance = glm::max(currentDistance, enterDistance);
 			if (currentDistance > maxDistance)
 			{
 				break;
 			}
+
+			if (MarchStep(origin, direction, minDistance, currentDistance, hitDistance, hitRecord))
+			{
+				break;
+			}
+			++currentStep;
 		}
 
-		hitRecord.Distance = currentDistance;
+		hitRecord.Distance = hitRecord.DidHit ? currentDistance : glm::max(currentDistance, maxDistance);
 		hitRecord.TotalSteps = currentStep;
 		if (currentStep != 0)
 		{
 			hitRecord.BVHDepth /= currentStep;
-			hitRecord.EarlyOutUsage;
 		}
 
 		return hitRecord;
 	}
 
+	bool Scene::MarchStep(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float& currentDistance, float& hitDistance, HitRecord& outHitRecord) const
+	{
+		glm::vec3 const newPoint{ origin + direction * currentDistance };
+		// const float sinDist{ std::sin(currentDistance * 0.3f) };
+		// const float sinTime{ std::sin(m_TotalTime * 0.4f) };
+		// newPoint = Matrix::CreateRotationZ(currentDistance * sinTime * 0.14).TransformPoint(newPoint);
+		// newPoint += Vector3{ 0.f, sinDist * sinTime * 10, 0.f } * 0.3f;
+		const auto [distanceAbleToTravel, object] { GetDistanceToScene(newPoint, outHitRecord) };
+		if (currentDistance > 0.f)
+		{
+			outHitRecord.ClearConeRatio = glm::min(outHitRecord.ClearConeRatio, distanceAbleToTravel / currentDistance);
+		}
+		currentDistance += distanceAbleToTravel;
+
+		if (distanceAbleToTravel < hitDistance)
+		{
+			if (distanceAbleToTravel >= minDistance)
+			{
+				std::optional<float> const refinedDistance{ RefineHit(origin, direction, currentDistance - distanceAbleToTravel, distanceAbleToTravel, minDistance, outHitRecord) };
+				if (not refinedDistance.has_value())
+				{
+					//grazing ray, keep marching with the precise threshold
+					hitDistance = minDistance;
+					return false;
+				}
+				currentDistance = refinedDistance.value();
+			}
+
+			outHitRecord.DidHit = true;
+			if (object)
+			{
+				outHitRecord.Shade = object->Shade();
+				outHitRecord.ObjectID = GetObjectID(object);
+			}
+			return true;
+		}
+		return false;
+	}
+
+	std::optional<float> Scene::RefineHit(const glm::vec3& origin, const glm::vec3& direction, float distance, float surfaceDistance, float minDistance, HitRecord& outHitRecord) const
+	{
+		float outsideDistance{ distance };
+		float outsideSurfaceDistance{ surfaceDistance };
+		float insideDistance{ distance };
+		float insideSurfaceDistance{ surfaceDistance };
+		float stepSize{ m_RefinementHitDistance };
+
+		//step forward until the sign of the sdf flips, the surface then lies between the outside and inside point
+		int bracketStep{ 0 };
+		for (; bracketStep < MaxBracketSteps; ++bracketStep)
+		{
+			insideDistance = outsideDistance + stepSize;
+			insideSurfaceDistance = GetDistanceToScene(origin + direction * insideDistance, outHitRecord).first;
+			++outHitRecord.RefinementSteps;
+
+			if (insideSurfaceDistance < 0.f)
+			{
+				break;
+			}
+			if (insideSurfaceDistance < minDistance)
+			{
+				return insideDistance;
+			}
+			//moving away from the surface again, so the coarse hit was a near miss
+			if (insideSurfaceDistance > outsideSurfaceDistance)
+			{
+				return std::nullopt;
+			}
+
+			outsideDistance = insideDistance;
+			outsideSurfaceDistance = insideSurfaceDistance;
+			stepSize *= 2.f;
+		}
+
+		if (bracketStep == MaxBracketSteps)
+		{
+			return std::nullopt;
+		}
+
+		float refinedDistance{ insideDistance };
+		for (int refinementStep{ 0 }; refinementStep < MaxRefinementSteps; ++refinementStep)
+		{
+			//false position, the secant through both bracket ends crosses zero inside the bracket
+			refinedDistance = outsideDistance + (insideDistance - outsideDistance) * outsideSurfaceDistance / (outsideSurfaceDistance - insideSurfaceDistance);
+
+			float const refinedSurfaceDistance{ GetDistanceToScene(origin + direction * refinedDistance, outHitRecord).first };
+			++outHitRecord.RefinementSteps;
+
+			if (glm::abs(refinedSurfaceDistance) < minDistance)
+			{
+				break;
+			}
+
+			if (refinedSurfaceDistance > 0.f)
+			{
+				outsideDistance = refinedDistance;
+				outsideSurfaceDistance = refinedSurfaceDistance;
+			}
+			else
+			{
+				insideDistance = refinedDistance;
+				insideSurfaceDistance = refinedSurfaceDistance;
+			}
+		}
+
+		return refinedDistance;
+	}
+
+	int Scene::GetObjectID(const sdf::Object* object) const
+	{
+		auto const objectIt
+		{
+			std::find_if(m_SDObjectUPtrVec.begin(), m_SDObjectUPtrVec.end(),
+			[object](const std::unique_ptr<sdf::Object>& obj)
+			{
+				return obj.get() == object;
+			})
+		};
+
+		return objectIt == m_SDObjectUPtrVec.end() ? -1 : static_cast<int>(std::distance(m_SDObjectUPtrVec.begin(), objectIt));
+	}
+
 	void Scene::Update(float ElapsedSec)
 	{
 		//m_Camera.Update(ElapsedSec);
@@ -107,6 +283,9 @@ namespace sdf
 
 	void Scene::CreateBVHStructure()
 	{
+		TraceZone const buildZone{ "BVH Build" };
+		PerfZone const perfZone{ PerfStage::Build };
+
 		std::vector<sdf::Object*> objectVec{ m_SDObjectUPtrVec.size() };
 
 		std::transform(m_SDObjectUPtrVec.begin(), m_SDObjectUPtrVec.end(), objectVec.begin(),
@@ -116,9 +295,20 @@ namespace sdf
 			});
 
 		m_BVHRoot = std::move(sdf::BVHNode::CreateBVHNode(objectVec));		
+		m_CostAwareBVH = BVHNode::m_CostAwareSAH;
+		++m_Version;
 	}
 	void Scene::MoveCameraPos(float moveDistance)
 	{
 		m_Camera.origin += m_Camera.forward * moveDistance;
 	}
+
+	void Scene::SetCamera(Camera const& camera)
+	{
+		m_Camera.origin = camera.origin;
+		m_Camera.fovAngle = camera.fovAngle;
+		m_Camera.fovValue = camera.fovValue;
+		m_Camera.forward = camera.forward;
+		m_Camera.CalculateCameraToWorld();
+	}
 }
\ No newline at end of file
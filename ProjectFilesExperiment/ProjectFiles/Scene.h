@@ -2,6 +2,7 @@
 #include "glm/glm.hpp"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -25,19 +26,31 @@ namespace sdf
 		Scene& operator=(Scene&&) noexcept = delete;
 
 		//returns the distance and the number of steps
-		HitRecord GetClosestHit(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps) const;
+		HitRecord GetClosestHit(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps, float startDistance = 0.f) const;
 
 		void Update(float ElapsedSec);
 
 		Camera const& GetCamera() const { return m_Camera; }
+		//changes whenever the geometry of the scene changes
+		uint32_t GetVersion() const { return m_Version; }
 
 		void CreateBVHStructure();
+		std::vector<std::unique_ptr<Object>> const& GetObjects() const { return m_SDObjectUPtrVec; }
+		//nullptr for scenes that never built one
+		BVHNode const* GetBVHRoot() const { return m_BVHRoot.get(); }
+		//whether the current bvh came from the cost aware sah, the toggle only applies on the next build
+		bool IsCostAwareBVH() const { return m_CostAwareBVH; }
 
 		static bool m_UseEarlyOut;
 		static bool m_UseBVH;
+		static bool m_UseBoundJumps;
+		static bool m_UseHitRefinement;
+		static float m_RefinementHitDistance;
 
 		//static int m_BVHSteps;
 		static void MoveCameraPos(float moveDistance);
+		//copies the position, orientation and field of view, for headless runs without input
+		static void SetCamera(Camera const& camera);
 	protected:
 		//vector needs full definition upon construction, so it can call the destructor of the unique_ptrs
 		std::vector<std::unique_ptr<Object>> m_SDObjectUPtrVec;
@@ -46,8 +59,19 @@ namespace sdf
 
 	private:
 		std::unique_ptr<BVHNode> m_BVHRoot{ nullptr };
+		uint32_t m_Version{ 0 };
+		bool m_CostAwareBVH{ false };
 
 		std::pair<float, const sdf::Object*> GetDistanceToScene(const glm::vec3& point, HitRecord& outHitRecord) const;
+		//index of the object in this scene, -1 when it is not part of it
+		int GetObjectID(const sdf::Object* object) const;
+		//only sphere traces inside the leaf bounds of the BVH and jumps analytically between them
+		HitRecord GetClosestHitBoundJumps(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float maxDistance, int maxSteps, float startDistance) const;
+		//one sphere tracing step from currentDistance, true once the ray hit, which fills in the hit of the record
+		//a grazing ray lowers hitDistance to minDistance so it keeps marching with the precise threshold
+		bool MarchStep(const glm::vec3& origin, const glm::vec3& direction, float minDistance, float& currentDistance, float& hitDistance, HitRecord& outHitRecord) const;
+		//brackets the surface behind a coarse hit and closes in on it with false position, empty when the ray only grazed it
+		std::optional<float> RefineHit(const glm::vec3& origin, const glm::vec3& direction, float distance, float surfaceDistance, float minDistance, HitRecord& outHitRecord) const;
 
 	};
 
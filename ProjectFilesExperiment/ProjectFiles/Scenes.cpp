@@ -92,3 +92,18 @@ sdf::SceneMandelBulb::SceneMandelBulb()
 {
     m_SDObjectUPtrVec.emplace_back(std::make_unique<sdf::MandelBulb>(glm::vec3{ 0.f, 0.f, 0.f }, colors::Blue));
 }
+
+std::vector<std::unique_ptr<sdf::Scene>> sdf::CreateScenes()
+{
+    std::vector<std::unique_ptr<Scene>> sceneUPtrVec{};
+    sceneUPtrVec.emplace_back(std::make_unique<SceneEasyComplexity>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneMediumComplexity>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneHighComplexity>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneLink>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneOctahedron>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneBoxFrame>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneHexagonalPrism>());
+    sceneUPtrVec.emplace_back(std::make_unique<ScenePyramid>());
+    sceneUPtrVec.emplace_back(std::make_unique<SceneMandelBulb>());
+    return sceneUPtrVec;
+}
@@ -82,4 +82,7 @@ namespace sdf
 	private:
 	};
 
+	//every scene in the order of the scene selection
+	std::vector<std::unique_ptr<Scene>> CreateScenes();
+
 }
\ No newline at end of file
@@ -3,38 +3,258 @@
 #include <SDL.h>
 #include <SDL_events.h>
 
+#include <chrono>
+
 #include "GUI.h"
 #include "Scenes.h"
+#include "Camera.h"
+#include "BVHNode.h"
+#include "SDFObjects.h"
+#include "Misc.h"
+#include "TraceRecorder.h"
 
 sdf::Engine::Engine(uint32_t const& width, uint32_t const& height)
-    : m_Renderer{ width, height }
+    : m_Profiler{}
+    , m_Renderer{ width, height, m_Profiler }
 	, m_Timer{}
+	, m_Governor{}
+	, m_SceneUPtrVec{ CreateScenes() }
+{
+}
+
+sdf::Engine::~Engine()
 {
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneEasyComplexity>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneMediumComplexity>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneHighComplexity>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneLink>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneOctahedron>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneBoxFrame>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneHexagonalPrism>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<ScenePyramid>());
-    m_SceneUPtrVec.emplace_back(std::make_unique<SceneMandelBulb>());
+    WaitForRenderJob();
+    if (m_RenderThread.joinable())
+    {
+        m_PipelineState = PipelineState::Quit;
+        m_PipelineState.notify_one();
+        m_RenderThread.join();
+    }
+
+    if (TraceRecorder::HasEvents())
+    {
+        ExportTrace();
+    }
 }
 
 void sdf::Engine::Run()
 {
     while (not ShouldQuit)
     {
-        m_Timer.Update();
+        TraceZone const frameZone{ "Frame" };
 
-        GUI::BeginFrame(*this);
-        
-        HandleInput();
+        if (m_UsePipelining)
+        {
+            RunPipelinedFrame();
+        }
+        else
+        {
+            //a job might still be in flight right after pipelining was switched off
+            if (WaitForRenderJob())
+            {
+                m_Renderer.UploadDetachedFrame();
+            }
+            RunFrame();
+
+            if (m_TraceExportRequested)
+            {
+                ExportTrace();
+            }
+        }
 
-        m_SceneUPtrVec[m_CurrentSceneID]->Update(m_Timer.GetElapsed());
-        
+        m_Profiler.EndFrame();
+    }
+}
+
+void sdf::Engine::RebuildBVHs()
+{
+    for (std::unique_ptr<Scene>& sceneUPtr : m_SceneUPtrVec)
+    {
+        sceneUPtr->CreateBVHStructure();
+    }
+}
+
+void sdf::Engine::RunFrame()
+{
+    UpdateFrame();
+    
+    //an unchanged frame would trace the exact same image, so only redraw the gui over the last one
+    bool isIdle{ false };
+    if (ShouldRender())
+    {
+        auto const renderStart{ std::chrono::high_resolution_clock::now() };
         m_Renderer.Render(*m_SceneUPtrVec[m_CurrentSceneID]);
+        std::chrono::duration<float> const renderTime{ std::chrono::high_resolution_clock::now() - renderStart };
+
+        //only frames that were actually traced say something about the cost of the current quality
+        m_Governor.Update(renderTime.count());
+    }
+    else if (m_Renderer.IsAccumulating())
+    {
+        m_Renderer.Accumulate(*m_SceneUPtrVec[m_CurrentSceneID]);
+    }
+    else
+    {
+        isIdle = true;
+    }
+
+    m_Renderer.Present();
+
+    if (isIdle)
+    {
+        WaitWhileIdle();
+    }
+}
+
+void sdf::Engine::RunPipelinedFrame()
+{
+    //the gui, input and scene update change what the render thread reads, so they wait for it to finish frame N
+    bool const hasNewFrame{ WaitForRenderJob() };
+
+    //the render thread is idle until the next request
+    if (m_TraceExportRequested)
+    {
+        ExportTrace();
+    }
+
+    UpdateFrame();
+
+    //frame N+1 gets traced while frame N is uploaded and presented
+    if (ShouldRender())
+    {
+        RequestRenderJob(RenderJob::Render);
+    }
+    else if (m_Renderer.IsAccumulating())
+    {
+        RequestRenderJob(RenderJob::Accumulate);
     }
+
+    if (hasNewFrame)
+    {
+        m_Renderer.UploadDetachedFrame();
+    }
+
+    m_Renderer.Present();
+
+    //nothing requested and nothing left to upload, the render thread stays idle too
+    if (m_PipelineState == PipelineState::Idle and not hasNewFrame)
+    {
+        WaitWhileIdle();
+    }
+}
+
+void sdf::Engine::UpdateFrame()
+{
+    m_Timer.Update();
+
+    {
+        ProfileZone const guiZone{ m_Profiler, ProfileStage::GUI };
+        GUI::BeginFrame(*this);
+    }
+
+    ProfileZone const updateZone{ m_Profiler, ProfileStage::Update };
+    HandleInput();
+
+    m_SceneUPtrVec[m_CurrentSceneID]->Update(m_Timer.GetElapsed());
+}
+
+bool sdf::Engine::ShouldRender()
+{
+    size_t const frameHash{ CalculateFrameHash() };
+    if (m_ForceRender or m_Timer.IsBenchmarkActive() or not m_HasRendered or frameHash != m_LastFrameHash or m_Renderer.IsCheckerboardPending())
+    {
+        m_LastFrameHash = frameHash;
+        m_HasRendered = true;
+        return true;
+    }
+    return false;
+}
+
+void sdf::Engine::WaitWhileIdle() const
+{
+    //leaves the event in the queue for HandleInput
+    SDL_WaitEventTimeout(nullptr, IdleTimeoutMs);
+}
+
+void sdf::Engine::RequestRenderJob(RenderJob renderJob)
+{
+    if (not m_RenderThread.joinable())
+    {
+        m_RenderThread = std::jthread{ [this] { RenderThreadLoop(); } };
+    }
+
+    m_RenderJob = renderJob;
+    m_PipelineState = PipelineState::Requested;
+    m_PipelineState.notify_one();
+}
+
+bool sdf::Engine::WaitForRenderJob()
+{
+    PipelineState state{ m_PipelineState.load() };
+    while (state == PipelineState::Requested)
+    {
+        m_PipelineState.wait(state);
+        state = m_PipelineState.load();
+    }
+
+    if (state != PipelineState::Done)
+    {
+        return false;
+    }
+
+    m_Renderer.SwapDetachedFrame();
+    if (m_RenderJob == RenderJob::Render)
+    {
+        m_Governor.Update(m_DetachedRenderTime);
+    }
+    m_PipelineState = PipelineState::Idle;
+    return true;
+}
+
+void sdf::Engine::RenderThreadLoop()
+{
+    while (true)
+    {
+        PipelineState state{ m_PipelineState.load() };
+        while (state != PipelineState::Requested and state != PipelineState::Quit)
+        {
+            m_PipelineState.wait(state);
+            state = m_PipelineState.load();
+        }
+
+        if (state == PipelineState::Quit)
+        {
+            return;
+        }
+
+        Scene const& scene{ *m_SceneUPtrVec[m_CurrentSceneID] };
+        auto const renderStart{ std::chrono::high_resolution_clock::now() };
+        if (m_RenderJob == RenderJob::Render)
+        {
+            m_Renderer.RenderDetached(scene);
+        }
+        else
+        {
+            m_Renderer.AccumulateDetached(scene);
+        }
+        std::chrono::duration<float> const renderTime{ std::chrono::high_resolution_clock::now() - renderStart };
+        m_DetachedRenderTime = renderTime.count();
+
+        m_PipelineState = PipelineState::Done;
+        m_PipelineState.notify_one();
+    }
+}
+
+void sdf::Engine::ExportTrace()
+{
+    m_TraceExportRequested = false;
+
+    if (TraceRecorder::Export("trace.json"))
+    {
+        std::cout << "Trace saved to trace.json, " << TraceRecorder::GetDroppedEvents() << " events did not fit" << "\n";
+    }
+    TraceRecorder::Clear();
 }
 
 int& sdf::Engine::SetCurrentSceneID()
@@ -42,6 +262,59 @@ int& sdf::Engine::SetCurrentSceneID()
     return m_CurrentSceneID;
 }
 
+bool& sdf::Engine::SetForceRender()
+{
+    return m_ForceRender;
+}
+
+bool& sdf::Engine::SetUsePipelining()
+{
+    return m_UsePipelining;
+}
+
+size_t sdf::Engine::CalculateFrameHash() const
+{
+    Scene const& scene{ *m_SceneUPtrVec[m_CurrentSceneID] };
+    Camera const& camera{ scene.GetCamera() };
+
+    size_t hash{ 0 };
+
+    HashCombine(hash, m_CurrentSceneID);
+    HashCombine(hash, scene.GetVersion());
+
+    HashCombine(hash, camera.origin.x);
+    HashCombine(hash, camera.origin.y);
+    HashCombine(hash, camera.origin.z);
+    HashCombine(hash, camera.forward.x);
+    HashCombine(hash, camera.forward.y);
+    HashCombine(hash, camera.forward.z);
+    HashCombine(hash, camera.fovValue);
+
+    HashCombine(hash, Scene::m_UseEarlyOut);
+    HashCombine(hash, Object::m_UseBoxEarlyOut);
+    HashCombine(hash, Scene::m_UseBVH);
+    HashCombine(hash, BVHNode::m_BoxBVH);
+    HashCombine(hash, Scene::m_UseBoundJumps);
+    HashCombine(hash, Scene::m_UseHitRefinement);
+    HashCombine(hash, Object::m_UseStepScale);
+    HashCombine(hash, Scene::m_RefinementHitDistance);
+    HashCombine(hash, Renderer::m_UseReprojection);
+    HashCombine(hash, Renderer::m_ReprojectionSafety);
+    HashCombine(hash, Renderer::m_ReprojectionDepthThreshold);
+    HashCombine(hash, Renderer::m_UseAccumulation);
+    HashCombine(hash, Renderer::m_UseCheckerboard);
+    HashCombine(hash, Renderer::m_UseStatistics);
+    HashCombine(hash, Renderer::m_UseSRGB);
+    HashCombine(hash, Renderer::m_UseAdaptiveSampling);
+    HashCombine(hash, Renderer::m_AdaptiveDepthThreshold);
+    HashCombine(hash, Renderer::m_DebugView);
+    HashCombine(hash, Renderer::m_RenderScale);
+    HashCombine(hash, Renderer::m_MaxSteps);
+    HashCombine(hash, Renderer::m_HitDistance);
+
+    return hash;
+}
+
 char const* const* sdf::Engine::GetSceneComplexities() const
 {
     return m_SceneComplexity.data();
@@ -1,9 +1,13 @@
 #pragma once
 #include <cstdint>
+#include <atomic>
+#include <thread>
 
 #include "Renderer.h"
 #include "Scene.h"
 #include "Timer.h"
+#include "QualityGovernor.h"
+#include "Profiler.h"
 
 namespace sdf
 {
@@ -12,7 +16,7 @@ namespace sdf
     {
     public:
         Engine(uint32_t const& width, uint32_t const& height);
-        ~Engine() = default;
+        ~Engine();
 
         Engine(const Engine&) = delete;
         Engine(Engine&&) noexcept = delete;
@@ -21,21 +25,76 @@ namespace sdf
     
         void Run();
         int& SetCurrentSceneID();
+        bool& SetForceRender();
+        bool& SetUsePipelining();
+        //the trace is written at the end of the frame, when no render job can be recording
+        void RequestTraceExport() { m_TraceExportRequested = true; }
+        //builds the bvh of every scene again with the current builder settings, only while no render job runs
+        void RebuildBVHs();
         char const* const* GetSceneComplexities() const;
         int GetSceneComplexityCount() const;
 
 		Renderer const& GetRenderer() const { return m_Renderer; }
 		GameTimer& GetTimer() { return m_Timer; }
+		QualityGovernor& GetGovernor() { return m_Governor; }
+		Profiler const& GetProfiler() const { return m_Profiler; }
+		Scene const& GetCurrentScene() const { return *m_SceneUPtrVec[m_CurrentSceneID]; }
     private:
+        //declared before the renderer, which keeps a reference to it
+        Profiler m_Profiler;
         Renderer m_Renderer;
         GameTimer m_Timer;
+        QualityGovernor m_Governor;
         std::vector<std::unique_ptr<Scene>> m_SceneUPtrVec{};
 
         int m_CurrentSceneID{ 0 };
         std::vector<const char*> m_SceneComplexity{ "Low", "Medium", "High", "Link", "Octahedron", "BoxFrame", "HexagonalPrism", "Pyramid", "MandelBulb" };
         
         bool ShouldQuit{ false };
+        bool m_TraceExportRequested{ false };
+        void ExportTrace();
         void HandleInput();
+
+        //benchmarks need every frame traced, even when nothing changed
+        bool m_ForceRender{ false };
+        bool m_HasRendered{ false };
+        size_t m_LastFrameHash{ 0 };
+        size_t CalculateFrameHash() const;
+        //traces or accumulates a new frame when something changed, returns false when the last one is still up to date
+        bool ShouldRender();
+        //a skipped frame would spin straight into the next one, so the loop sleeps until input arrives or the timeout passes
+        static constexpr uint32_t IdleTimeoutMs{ 16 };
+        void WaitWhileIdle() const;
+
+        //frame N+1 is traced on the render thread while the main thread presents frame N, at the cost of a frame of latency
+        enum class PipelineState
+        {
+            Idle,
+            Requested,
+            Done,
+            Quit
+        };
+        enum class RenderJob
+        {
+            Render,
+            Accumulate
+        };
+
+        bool m_UsePipelining{ false };
+        std::atomic<PipelineState> m_PipelineState{ PipelineState::Idle };
+        RenderJob m_RenderJob{ RenderJob::Render };
+        //only written by the render thread between Requested and Done
+        float m_DetachedRenderTime{ 0.f };
+        std::jthread m_RenderThread{};
+
+        //timer, gui, input and scene, everything before a frame gets traced
+        void UpdateFrame();
+        void RunFrame();
+        void RunPipelinedFrame();
+        void RequestRenderJob(RenderJob renderJob);
+        //blocks until the render thread is done with its job, then hands the frame to the main thread, false when there was none
+        bool WaitForRenderJob();
+        void RenderThreadLoop();
     };
 
 }
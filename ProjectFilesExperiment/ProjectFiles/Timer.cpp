@@ -16,7 +16,7 @@ sdf::GameTimer::GameTimer()
 	m_PreviousTime = m_StartTime;
 }
 
-void sdf::GameTimer::StartBenchmark(std::string const& sceneName, sdf::ResultStats const& hitStats, sdf::ResultStats const& missStats)
+void sdf::GameTimer::StartBenchmark(std::string const& sceneName, bool costAwareBVH, sdf::ResultStats const& hitStats, sdf::ResultStats const& missStats)
 {
 	if (m_BenchmarkActive)
 	{
@@ -30,9 +30,13 @@ void sdf::GameTimer::StartBenchmark(std::string const& sceneName, sdf::ResultSta
 	m_BenchmarkFrameTimeVec.reserve(60 * m_BenchmarkTargetTime);
 
 	m_CurrentSceneName = sceneName;
+	m_CostAwareBVH = costAwareBVH;
 	m_HitStats = hitStats;
 	m_MissStats = missStats;
 
+	m_BenchmarkCounters.ValueArr.fill(PerfCounters::IsAvailable() ? 0 : -1);
+	m_BenchmarkCounterFrames = 0;
+
 	std::cout << "**BENCHMARK STARTED**\n";
 }
 
@@ -61,6 +65,15 @@ void sdf::GameTimer::Update()
 		m_BenchmarkTime += m_ElapsedTime;
 		m_BenchmarkFrameTimeVec.emplace_back(m_ElapsedTime); 
 
+		//benchmarks trace every frame, so the last trace sample belongs to the frame that just ended
+		PerfSample const traceSample{ PerfCounters::GetStageSample(PerfStage::Trace) };
+		for (int counterIdx{ 0 }; counterIdx < PerfSample::CounterCount; ++counterIdx)
+		{
+			int64_t& counterSum{ m_BenchmarkCounters.ValueArr[counterIdx] };
+			counterSum = counterSum >= 0 and traceSample.ValueArr[counterIdx] >= 0 ? counterSum + traceSample.ValueArr[counterIdx] : -1;
+		}
+		++m_BenchmarkCounterFrames;
+
 		if (m_BenchmarkTime >= m_BenchmarkTargetTime)
 		{
 			EndBenchmark();
@@ -115,6 +128,19 @@ void sdf::GameTimer::OutputBenchmarkResults(std::vector<float> const& frameTimeV
 			<< delimiter << "BOX EARLY OUT"
 			<< delimiter << "BVH"
 			<< delimiter << "BOX BVH"
+			<< delimiter << "COST AWARE SAH"
+			<< delimiter << "BOUND JUMPS"
+			<< delimiter << "HIT REFINEMENT"
+			<< delimiter << "STEP SCALE"
+			<< delimiter << "REPROJECTION"
+			<< delimiter << "RENDER SCALE"
+			<< delimiter << "CHECKERBOARD"
+			<< delimiter << "ADAPTIVE"
+			<< delimiter << "STATISTICS"
+			<< delimiter << "SRGB"
+			<< delimiter << "TEXTURE LOCKING"
+			<< delimiter << "MAX STEPS"
+			<< delimiter << "HIT DISTANCE"
 			<< delimiter << "TOTAL TIME"
 			<< delimiter << "TOTAL FRAMES"
 			<< delimiter << "AVG TIME"
@@ -122,11 +148,25 @@ void sdf::GameTimer::OutputBenchmarkResults(std::vector<float> const& frameTimeV
 			<< delimiter << "HIT RAYS"
 			<< delimiter << "AVG STEPS"
 			<< delimiter << "AVG EARLY OUT"
+			<< delimiter << "AVG REFINE STEPS"
 			<< delimiter << "AVG BVH DEPTH"
+			<< delimiter << "P50 STEPS"
+			<< delimiter << "P95 STEPS"
+			<< delimiter << "P99 STEPS"
 			<< delimiter << "MISSED RAYS"
 			<< delimiter << "AVG STEPS"
 			<< delimiter << "AVG EARLY OUT"
+			<< delimiter << "AVG REFINE STEPS"
 			<< delimiter << "AVG BVH DEPTH"
+			<< delimiter << "P50 STEPS"
+			<< delimiter << "P95 STEPS"
+			<< delimiter << "P99 STEPS"
+			<< delimiter << "AVG CYCLES"
+			<< delimiter << "AVG INSTRUCTIONS"
+			<< delimiter << "AVG L1D MISSES"
+			<< delimiter << "AVG LLC MISSES"
+			<< delimiter << "AVG BRANCH MISSES"
+			<< delimiter << "IPC"
 			<< delimiter << "FRAME TIMES\n";
 	}
 
@@ -136,6 +176,19 @@ void sdf::GameTimer::OutputBenchmarkResults(std::vector<float> const& frameTimeV
 		<< std::boolalpha << Object::m_UseBoxEarlyOut << delimiter
 		<< std::boolalpha << Scene::m_UseBVH << delimiter
 		<< std::boolalpha << BVHNode::m_BoxBVH << delimiter
+		<< std::boolalpha << m_CostAwareBVH << delimiter
+		<< std::boolalpha << Scene::m_UseBoundJumps << delimiter
+		<< std::boolalpha << Scene::m_UseHitRefinement << delimiter
+		<< std::boolalpha << Object::m_UseStepScale << delimiter
+		<< std::boolalpha << Renderer::m_UseReprojection << delimiter
+		<< std::to_string(Renderer::m_RenderScale) << delimiter
+		<< std::boolalpha << Renderer::m_UseCheckerboard << delimiter
+		<< std::boolalpha << Renderer::m_UseAdaptiveSampling << delimiter
+		<< std::boolalpha << Renderer::m_UseStatistics << delimiter
+		<< std::boolalpha << Renderer::m_UseSRGB << delimiter
+		<< std::boolalpha << Renderer::m_UseTextureLocking << delimiter
+		<< std::to_string(Renderer::m_MaxSteps) << delimiter
+		<< std::to_string(Renderer::m_HitDistance) << delimiter
 		<< std::to_string(benchMarkTotalTime) << delimiter
 		<< std::to_string(sortedFrameTimes.size()) << delimiter
 		<< std::to_string(avgFrameTime) << delimiter
@@ -143,11 +196,36 @@ void sdf::GameTimer::OutputBenchmarkResults(std::vector<float> const& frameTimeV
 		<< std::to_string(m_HitStats.Count) << delimiter
 		<< std::to_string(m_HitStats.AverageStepsThroughScene) << delimiter
 		<< std::to_string(m_HitStats.AverageEarlyOutSteps) << delimiter
+		<< std::to_string(m_HitStats.AverageRefinementSteps) << delimiter
 		<< std::to_string(m_HitStats.AverageBVHDepth) << delimiter
+		<< std::to_string(m_HitStats.MedianSteps) << delimiter
+		<< std::to_string(m_HitStats.P95Steps) << delimiter
+		<< std::to_string(m_HitStats.P99Steps) << delimiter
 		<< std::to_string(m_MissStats.Count) << delimiter
 		<< std::to_string(m_MissStats.AverageStepsThroughScene) << delimiter
 		<< std::to_string(m_MissStats.AverageEarlyOutSteps) << delimiter
-		<< std::to_string(m_MissStats.AverageBVHDepth) << delimiter;
+		<< std::to_string(m_MissStats.AverageRefinementSteps) << delimiter
+		<< std::to_string(m_MissStats.AverageBVHDepth) << delimiter
+		<< std::to_string(m_MissStats.MedianSteps) << delimiter
+		<< std::to_string(m_MissStats.P95Steps) << delimiter
+		<< std::to_string(m_MissStats.P99Steps) << delimiter;
+
+	//unavailable counters stay empty instead of showing up as zero
+	for (int counterIdx{ 0 }; counterIdx < PerfSample::CounterCount; ++counterIdx)
+	{
+		if (int64_t const counterSum{ m_BenchmarkCounters.ValueArr[counterIdx] };
+			counterSum >= 0 and m_BenchmarkCounterFrames > 0)
+		{
+			outputStream << std::to_string(counterSum / m_BenchmarkCounterFrames);
+		}
+		outputStream << delimiter;
+	}
+	if (float const instructionsPerCycle{ m_BenchmarkCounters.GetInstructionsPerCycle() };
+		instructionsPerCycle >= 0.f)
+	{
+		outputStream << std::to_string(instructionsPerCycle);
+	}
+	outputStream << delimiter;
 
 	for (const auto& time : sortedFrameTimes)
 	{
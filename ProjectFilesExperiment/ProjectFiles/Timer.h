@@ -7,6 +7,7 @@
 #include <iostream>
 
 #include "Misc.h"
+#include "PerfCounters.h"
 
 namespace sdf
 {
@@ -21,10 +22,11 @@ namespace sdf
 		GameTimer& operator=(const GameTimer&) = delete;
 		GameTimer& operator=(GameTimer&&) noexcept = delete;
 
-		void StartBenchmark(std::string const& sceneName, sdf::ResultStats const& hitStats, sdf::ResultStats const& missStats);
+		void StartBenchmark(std::string const& sceneName, bool costAwareBVH, sdf::ResultStats const& hitStats, sdf::ResultStats const& missStats);
 		void Update();
 		
 		float GetElapsed() const { return m_ElapsedTime; }
+		bool IsBenchmarkActive() const { return m_BenchmarkActive; }
 
 		float& SetBenchmarkTargetFrames() { return m_BenchmarkTargetTime; }
 	private:
@@ -45,8 +47,13 @@ namespace sdf
 		std::vector<float> m_BenchmarkFrameTimeVec{};
 
 		std::string m_CurrentSceneName{};
+		//builder of the bvh that was benchmarked, not the toggle for the next build
+		bool m_CostAwareBVH{ false };
 		ResultStats m_HitStats{};
 		ResultStats m_MissStats{};
+		//hardware counters summed over the traced frames of the benchmark
+		PerfSample m_BenchmarkCounters{};
+		uint32_t m_BenchmarkCounterFrames{ 0 };
 
 		void PrintFPS() const;
 		void EndBenchmark();
@@ -0,0 +1,146 @@
+#include "TraceRecorder.h"
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+
+#include "Misc.h"
+
+bool sdf::TraceRecorder::m_Enabled{ false };
+
+namespace
+{
+	struct TraceEvent
+	{
+		char const* Name{};
+		int64_t Start{};
+		int64_t Duration{};
+		int64_t Arg{};
+	};
+
+	//about 8 mb per thread that records, allocated by that thread on its first event
+	constexpr uint32_t BufferCapacity{ 1u << 18 };
+
+	struct alignas(sdf::CacheLineSize) ThreadBuffer
+	{
+		std::unique_ptr<TraceEvent[]> EventArr{};
+		//released after the event is written, so Export only reads finished events
+		std::atomic<uint32_t> Count{ 0 };
+		std::atomic<int64_t> Dropped{ 0 };
+	};
+
+	std::array<ThreadBuffer, sdf::MaxThreadSlots> g_ThreadBufferArr{};
+	//events of threads that found every slot taken
+	std::atomic<int64_t> g_UnslottedDropped{ 0 };
+	sdf::TraceRecorder::TimePoint const g_StartTime{ std::chrono::high_resolution_clock::now() };
+
+	int64_t ToNanoseconds(sdf::TraceRecorder::TimePoint const& timePoint)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint - g_StartTime).count();
+	}
+}
+
+void sdf::TraceRecorder::Record(char const* name, TimePoint const& startTime, TimePoint const& endTime, int64_t arg)
+{
+	int const slotIdx{ GetThreadSlot() };
+	if (slotIdx == NoThreadSlot)
+	{
+		g_UnslottedDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ThreadBuffer& threadBuffer{ g_ThreadBufferArr[slotIdx] };
+
+	uint32_t const count{ threadBuffer.Count.load(std::memory_order_relaxed) };
+	if (count == BufferCapacity)
+	{
+		threadBuffer.Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	if (not threadBuffer.EventArr)
+	{
+		threadBuffer.EventArr = std::make_unique<TraceEvent[]>(BufferCapacity);
+	}
+
+	int64_t const start{ ToNanoseconds(startTime) };
+	threadBuffer.EventArr[count] = TraceEvent{ name, start, ToNanoseconds(endTime) - start, arg };
+	threadBuffer.Count.store(count + 1, std::memory_order_release);
+}
+
+bool sdf::TraceRecorder::Export(std::string const& fileName)
+{
+	std::ofstream fileStream{ fileName };
+	if (not fileStream)
+	{
+		return false;
+	}
+
+	//complete events carry their begin and end in one entry, the viewer expects microseconds
+	fileStream << std::fixed << std::setprecision(3);
+	fileStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	fileStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"SphereTracer\"}}";
+
+	int const usedSlots{ GetUsedThreadSlots() };
+	for (int slotIdx{ 0 }; slotIdx < usedSlots; ++slotIdx)
+	{
+		ThreadBuffer const& threadBuffer{ g_ThreadBufferArr[slotIdx] };
+		uint32_t const count{ threadBuffer.Count.load(std::memory_order_acquire) };
+		if (count == 0)
+		{
+			continue;
+		}
+
+		fileStream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << slotIdx << ",\"args\":{\"name\":\"thread " << slotIdx << "\"}}";
+
+		for (uint32_t eventIdx{ 0 }; eventIdx < count; ++eventIdx)
+		{
+			TraceEvent const& event{ threadBuffer.EventArr[eventIdx] };
+			fileStream << ",\n{\"name\":\"" << event.Name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << slotIdx
+				<< ",\"ts\":" << event.Start / 1000.0 << ",\"dur\":" << event.Duration / 1000.0;
+			if (event.Arg >= 0)
+			{
+				fileStream << ",\"args\":{\"idx\":" << event.Arg << '}';
+			}
+			fileStream << '}';
+		}
+	}
+
+	fileStream << "\n]}\n";
+	return static_cast<bool>(fileStream);
+}
+
+void sdf::TraceRecorder::Clear()
+{
+	for (ThreadBuffer& threadBuffer : g_ThreadBufferArr)
+	{
+		threadBuffer.Count.store(0, std::memory_order_relaxed);
+		threadBuffer.Dropped.store(0, std::memory_order_relaxed);
+	}
+	g_UnslottedDropped.store(0, std::memory_order_relaxed);
+}
+
+bool sdf::TraceRecorder::HasEvents()
+{
+	int const usedSlots{ GetUsedThreadSlots() };
+	for (int slotIdx{ 0 }; slotIdx < usedSlots; ++slotIdx)
+	{
+		if (g_ThreadBufferArr[slotIdx].Count.load(std::memory_order_acquire) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int64_t sdf::TraceRecorder::GetDroppedEvents()
+{
+	int64_t dropped{ g_UnslottedDropped.load(std::memory_order_relaxed) };
+	for (ThreadBuffer const& threadBuffer : g_ThreadBufferArr)
+	{
+		dropped += threadBuffer.Dropped.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
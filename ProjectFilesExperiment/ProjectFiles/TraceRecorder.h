@@ -0,0 +1,61 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace sdf
+{
+
+	//timeline of frames, stages, tiles and scene builds per thread, written as chrome trace json for perfetto or chrome://tracing
+	class TraceRecorder final
+	{
+	public:
+		using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+
+		TraceRecorder() = delete;
+
+		static bool m_Enabled;
+
+		//lock free, every thread appends to the buffer of its own thread slot, name has to outlive the recorder
+		static void Record(char const* name, TimePoint const& startTime, TimePoint const& endTime, int64_t arg = -1);
+		//must not overlap Record calls of other threads
+		static bool Export(std::string const& fileName);
+		static void Clear();
+
+		static bool HasEvents();
+		//events that did not fit in the buffer of their thread since the last Clear
+		static int64_t GetDroppedEvents();
+	};
+
+	//records the time between construction and destruction when tracing was enabled at construction
+	class TraceZone final
+	{
+	public:
+		explicit TraceZone(char const* name, int64_t arg = -1)
+			: m_Name{ TraceRecorder::m_Enabled ? name : nullptr }
+			, m_Arg{ arg }
+		{
+			if (m_Name)
+			{
+				m_StartTime = std::chrono::high_resolution_clock::now();
+			}
+		}
+		~TraceZone()
+		{
+			if (m_Name)
+			{
+				TraceRecorder::Record(m_Name, m_StartTime, std::chrono::high_resolution_clock::now(), m_Arg);
+			}
+		}
+
+		TraceZone(const TraceZone&) = delete;
+		TraceZone(TraceZone&&) noexcept = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+		TraceZone& operator=(TraceZone&&) noexcept = delete;
+	private:
+		char const* m_Name;
+		int64_t m_Arg;
+		TraceRecorder::TimePoint m_StartTime{};
+	};
+
+}
@@ -0,0 +1,974 @@
+#include "Validation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <execution>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Misc.h"
+#include "Camera.h"
+#include "Scenes.h"
+#include "SDFObjects.h"
+#include "BVHNode.h"
+#include "Renderer.h"
+#include "RayDirectionTable.h"
+#include "Profiler.h"
+#include "PrimitiveProfiler.h"
+
+namespace
+{
+	//every setting that is only supposed to change how fast a frame renders
+	struct AccelerationSettings
+	{
+		bool UseEarlyOut{ false };
+		bool UseBoxEarlyOut{ false };
+		bool UseBVH{ false };
+		bool BoxBVH{ false };
+		bool UseBoundJumps{ false };
+		bool CostAwareSAH{ false };
+
+		static AccelerationSettings Capture()
+		{
+			return AccelerationSettings
+			{
+				sdf::Scene::m_UseEarlyOut,
+				sdf::Object::m_UseBoxEarlyOut,
+				sdf::Scene::m_UseBVH,
+				sdf::BVHNode::m_BoxBVH,
+				sdf::Scene::m_UseBoundJumps,
+				sdf::BVHNode::m_CostAwareSAH
+			};
+		}
+
+		void Apply() const
+		{
+			sdf::Scene::m_UseEarlyOut = UseEarlyOut;
+			sdf::Object::m_UseBoxEarlyOut = UseBoxEarlyOut;
+			sdf::Scene::m_UseBVH = UseBVH;
+			sdf::BVHNode::m_BoxBVH = BoxBVH;
+			sdf::Scene::m_UseBoundJumps = UseBoundJumps;
+			sdf::BVHNode::m_CostAwareSAH = CostAwareSAH;
+		}
+
+		std::string GetName() const
+		{
+			std::string name{ UseEarlyOut ? (UseBoxEarlyOut ? "box early out" : "sphere early out") : "no early out" };
+			if (UseBVH)
+			{
+				name += BoxBVH ? ", box bvh" : ", sphere bvh";
+				name += UseBoundJumps ? " with bound jumps" : "";
+				name += CostAwareSAH ? ", cost aware sah" : "";
+			}
+			return name;
+		}
+	};
+
+	//same dependencies as the settings window, the box variants and bound jumps only exist with their parent on
+	std::vector<AccelerationSettings> CreateSettingCombinations(bool costAwareSAH)
+	{
+		std::vector<AccelerationSettings> settingVec{};
+		for (int earlyOutMode{ 0 }; earlyOutMode < 3; ++earlyOutMode)
+		{
+			for (int bvhMode{ 0 }; bvhMode < 5; ++bvhMode)
+			{
+				//without a bvh the builder makes no difference
+				if (bvhMode == 0 and costAwareSAH)
+				{
+					continue;
+				}
+
+				AccelerationSettings settings{};
+				settings.UseEarlyOut = earlyOutMode > 0;
+				settings.UseBoxEarlyOut = earlyOutMode == 2;
+				settings.UseBVH = bvhMode > 0;
+				settings.BoxBVH = bvhMode == 2 or bvhMode == 4;
+				settings.UseBoundJumps = bvhMode >= 3;
+				settings.CostAwareSAH = costAwareSAH;
+				settingVec.emplace_back(settings);
+			}
+		}
+		return settingVec;
+	}
+
+	//every renderer setting that fills pixels in or reuses them from the previous frame instead of tracing them
+	struct RendererSettings
+	{
+		bool UseReprojection{ false };
+		bool UseCheckerboard{ false };
+		bool UseAdaptiveSampling{ false };
+		float RenderScale{ 1.f };
+		sdf::Renderer::DebugView DebugView{ sdf::Renderer::DebugView::None };
+
+		static RendererSettings Capture()
+		{
+			return RendererSettings
+			{
+				sdf::Renderer::m_UseReprojection,
+				sdf::Renderer::m_UseCheckerboard,
+				sdf::Renderer::m_UseAdaptiveSampling,
+				sdf::Renderer::m_RenderScale,
+				sdf::Renderer::m_DebugView
+			};
+		}
+
+		void Apply() const
+		{
+			sdf::Renderer::m_UseReprojection = UseReprojection;
+			sdf::Renderer::m_UseCheckerboard = UseCheckerboard;
+			sdf::Renderer::m_UseAdaptiveSampling = UseAdaptiveSampling;
+			sdf::Renderer::m_RenderScale = RenderScale;
+			sdf::Renderer::m_DebugView = DebugView;
+		}
+
+		//only reprojection traces every pixel, it only moves where the trace starts
+		bool FillsPixels() const { return UseCheckerboard or UseAdaptiveSampling; }
+		//a filled pixel can be off by as much as the depth spread across which the mode still fills,
+		//adaptive sampling takes over from the checkerboard
+		float GetRelativeDepthTolerance() const
+		{
+			float const fillTolerance{ UseAdaptiveSampling ? sdf::Renderer::m_AdaptiveDepthThreshold : (UseCheckerboard ? sdf::Renderer::m_CheckerboardDepthTolerance : 0.f) };
+			return glm::max(sdf::Validation::RelativeDepthTolerance, fillTolerance);
+		}
+
+		std::string GetName() const
+		{
+			std::string name{};
+			auto const addPart{ [&name](std::string const& part) { name += (name.empty() ? "" : ", ") + part; } };
+			if (UseReprojection)
+			{
+				addPart("reprojection");
+			}
+			if (UseCheckerboard)
+			{
+				addPart("checkerboard");
+			}
+			if (UseAdaptiveSampling)
+			{
+				addPart("adaptive sampling");
+			}
+			if (RenderScale != 1.f)
+			{
+				addPart("render scale " + std::to_string(static_cast<int>(RenderScale * 100.f + 0.5f)) + "%");
+			}
+			return name;
+		}
+	};
+
+	std::array<sdf::Camera, 2> CreateCameras()
+	{
+		return
+		{
+			sdf::Camera{ glm::vec3{ 3.f, 2.f, 8.f }, 90.f, glm::normalize(glm::vec3{ -0.35f, -0.2f, -1.f }) },
+			sdf::Camera{ glm::vec3{ -6.f, 4.f, -6.f }, 70.f, glm::normalize(glm::vec3{ 6.f, -4.f, 6.f }) }
+		};
+	}
+
+	//prints and counts the failure, as a known one when the baseline expects it so it does not fail the check
+	void ReportFailure(std::string const& name, std::string const& details, sdf::Validation::KnownFailureSet const& knownFailures, int& outFailedCount, int& outKnownCount)
+	{
+		bool const known{ knownFailures.contains(name) };
+		std::cout << (known ? "KNOWN " : "FAIL ") << name << ": " << details << "\n";
+		++(known ? outKnownCount : outFailedCount);
+	}
+
+	std::vector<sdf::HitRecord> RenderHits(sdf::Scene const& scene, sdf::Camera const& camera)
+	{
+		constexpr uint32_t pixelCount{ sdf::Validation::RenderSize * sdf::Validation::RenderSize };
+
+		//the directions the renderer itself would trace
+		sdf::RayDirectionTable directionTable{};
+		directionTable.Update(sdf::Validation::RenderSize, sdf::Validation::RenderSize, 1.f, camera.fovValue, camera.cameraToWorld);
+
+		std::vector<uint32_t> pixelIdxVec(pixelCount);
+		std::iota(pixelIdxVec.begin(), pixelIdxVec.end(), 0);
+
+		std::vector<sdf::HitRecord> hitRecordVec(pixelCount);
+		std::for_each(std::execution::par, pixelIdxVec.begin(), pixelIdxVec.end(), [&](uint32_t pixelIdx)
+			{
+				hitRecordVec[pixelIdx] = scene.GetClosestHit(camera.origin, directionTable.GetDirection(pixelIdx), sdf::Renderer::m_HitDistance, 1000, sdf::Renderer::m_MaxSteps);
+			});
+		return hitRecordVec;
+	}
+
+	struct RenderDifference
+	{
+		int HitDifferences{};
+		int ObjectIDDifferences{};
+		int DepthDifferences{};
+		float MaxDepthError{};
+
+		int GetDifferingPixels() const { return HitDifferences + ObjectIDDifferences + DepthDifferences; }
+		std::string GetDescription() const
+		{
+			return std::to_string(HitDifferences) + " hit, " + std::to_string(ObjectIDDifferences) + " object id, "
+				+ std::to_string(DepthDifferences) + " depth differences, max depth error " + std::to_string(MaxDepthError);
+		}
+	};
+
+	RenderDifference CompareHits(std::vector<sdf::HitRecord> const& referenceVec, std::vector<sdf::HitRecord> const& testVec, float relativeDepthTolerance = sdf::Validation::RelativeDepthTolerance)
+	{
+		RenderDifference difference{};
+		for (size_t pixelIdx{ 0 }; pixelIdx < referenceVec.size(); ++pixelIdx)
+		{
+			sdf::HitRecord const& reference{ referenceVec[pixelIdx] };
+			sdf::HitRecord const& test{ testVec[pixelIdx] };
+
+			if (reference.DidHit != test.DidHit)
+			{
+				++difference.HitDifferences;
+			}
+			else if (reference.DidHit)
+			{
+				if (reference.ObjectID != test.ObjectID)
+				{
+					++difference.ObjectIDDifferences;
+					continue;
+				}
+
+				float const depthError{ glm::abs(reference.Distance - test.Distance) };
+				difference.MaxDepthError = glm::max(difference.MaxDepthError, depthError);
+				if (depthError > glm::max(sdf::Validation::DepthTolerance, reference.Distance * relativeDepthTolerance))
+				{
+					++difference.DepthDifferences;
+				}
+			}
+		}
+		return difference;
+	}
+
+	struct BoundReport
+	{
+		std::string Name{};
+		int Samples{};
+		int Violations{};
+		//bound distance minus surface distance at the worst point found
+		float WorstExcess{ -FLT_MAX };
+		glm::vec3 WorstPoint{};
+	};
+
+	//a dense grid over the cube around the bound, then a gradient ascent from the worst cells,
+	//independent of the random search the objects pad their bounds with
+	BoundReport SampleBound(glm::vec3 const& center, float halfSize, std::function<float(glm::vec3 const&)> const& getExcess)
+	{
+		BoundReport report{};
+		auto const sample
+		{
+			[&](glm::vec3 const& point)
+			{
+				float const excess{ getExcess(point) };
+				++report.Samples;
+				if (excess > sdf::Validation::BoundTolerance)
+				{
+					++report.Violations;
+				}
+				if (excess > report.WorstExcess)
+				{
+					report.WorstExcess = excess;
+					report.WorstPoint = point;
+				}
+				return excess;
+			}
+		};
+
+		int const resolution{ sdf::Validation::BoundGridResolution };
+		float const cellSize{ 2.f * halfSize / resolution };
+		glm::vec3 const firstCell{ center - glm::vec3{ halfSize - 0.5f * cellSize } };
+
+		std::vector<std::pair<float, glm::vec3>> cellVec{};
+		cellVec.reserve(resolution * resolution * resolution);
+		for (int z{ 0 }; z < resolution; ++z)
+		{
+			for (int y{ 0 }; y < resolution; ++y)
+			{
+				for (int x{ 0 }; x < resolution; ++x)
+				{
+					glm::vec3 const point{ firstCell + glm::vec3{ x, y, z } * cellSize };
+					cellVec.emplace_back(sample(point), point);
+				}
+			}
+		}
+
+		int const ascentCount{ glm::min(sdf::Validation::RefinedBoundSamples, static_cast<int>(cellVec.size())) };
+		std::partial_sort(cellVec.begin(), cellVec.begin() + ascentCount, cellVec.end(),
+			[](auto const& a, auto const& b)
+			{
+				return a.first > b.first;
+			});
+
+		float const gradientStep{ sdf::Validation::GradientStep };
+		for (int ascentIdx{ 0 }; ascentIdx < ascentCount; ++ascentIdx)
+		{
+			auto [bestExcess, bestPoint] { cellVec[ascentIdx] };
+			//the cell is the area the grid already covers, the ascent looks for the peak inside it and its neighbours
+			float stepSize{ cellSize };
+			for (int stepIdx{ 0 }; stepIdx < sdf::Validation::RefinementSteps and bestExcess != -FLT_MAX; ++stepIdx)
+			{
+				glm::vec3 const gradient
+				{
+					getExcess(bestPoint + glm::vec3{ gradientStep, 0.f, 0.f }) - getExcess(bestPoint - glm::vec3{ gradientStep, 0.f, 0.f }),
+					getExcess(bestPoint + glm::vec3{ 0.f, gradientStep, 0.f }) - getExcess(bestPoint - glm::vec3{ 0.f, gradientStep, 0.f }),
+					getExcess(bestPoint + glm::vec3{ 0.f, 0.f, gradientStep }) - getExcess(bestPoint - glm::vec3{ 0.f, 0.f, gradientStep })
+				};
+				//flat, or next to the part of a node that hands the query to its children
+				if (not std::isfinite(glm::dot(gradient, gradient)) or glm::dot(gradient, gradient) == 0.f)
+				{
+					break;
+				}
+
+				glm::vec3 const point{ bestPoint + glm::normalize(gradient) * stepSize };
+				if (float const excess{ sample(point) };
+					excess > bestExcess)
+				{
+					bestExcess = excess;
+					bestPoint = point;
+				}
+				else
+				{
+					stepSize *= 0.5f;
+				}
+			}
+		}
+		return report;
+	}
+}
+
+bool sdf::Validation::Run(std::string const& stepScaleFileName)
+{
+	//the render checks trace with the estimated step scales, the same way a run with a saved file does
+	bool passed{ EstimateStepScales(stepScaleFileName) };
+	passed = ValidateRenderModes() and passed;
+	passed = ValidateBounds() and passed;
+	passed = ValidateRendererPaths() and passed;
+	passed = ValidateCheckerboard() and passed;
+	passed = ValidateDisocclusion() and passed;
+
+	std::cout << (passed ? "Validation passed" : "Validation failed") << "\n";
+	return passed;
+}
+
+sdf::Validation::KnownFailureSet sdf::Validation::LoadKnownFailures(std::string const& fileName)
+{
+	KnownFailureSet knownFailures{};
+	std::ifstream fileStream{ fileName };
+	std::string line{};
+	while (std::getline(fileStream, line))
+	{
+		//files checked out on windows keep their carriage returns
+		if (not line.empty() and line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (line.empty() or line.front() == '#')
+		{
+			continue;
+		}
+		knownFailures.emplace(line);
+	}
+	return knownFailures;
+}
+
+bool sdf::Validation::ValidateRenderModes(KnownFailureSet const& knownFailures)
+{
+	std::cout << "Render modes against brute force, " << RenderSize << "x" << RenderSize << " per camera\n";
+
+	AccelerationSettings const originalSettings{ AccelerationSettings::Capture() };
+	bool const originalHitRefinement{ Scene::m_UseHitRefinement };
+	//refinement moves every hit on purpose, it is not an acceleration
+	Scene::m_UseHitRefinement = false;
+
+	std::array<Camera, 2> const cameraArr{ CreateCameras() };
+
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+
+	//brute force first, every mode of a scene and camera is compared to it
+	AccelerationSettings{}.Apply();
+	std::vector<std::vector<HitRecord>> referenceVec{};
+	for (std::unique_ptr<Scene> const& sceneUPtr : sceneUPtrVec)
+	{
+		for (Camera const& camera : cameraArr)
+		{
+			referenceVec.emplace_back(RenderHits(*sceneUPtr, camera));
+		}
+	}
+
+	int failedCount{ 0 };
+	int knownCount{ 0 };
+	int testedCount{ 0 };
+	for (bool const costAwareSAH : { false, true })
+	{
+		BVHNode::m_CostAwareSAH = costAwareSAH;
+		for (std::unique_ptr<Scene> const& sceneUPtr : sceneUPtrVec)
+		{
+			sceneUPtr->CreateBVHStructure();
+		}
+
+		for (AccelerationSettings const& settings : CreateSettingCombinations(costAwareSAH))
+		{
+			settings.Apply();
+			for (size_t sceneIdx{ 0 }; sceneIdx < sceneUPtrVec.size(); ++sceneIdx)
+			{
+				for (size_t cameraIdx{ 0 }; cameraIdx < cameraArr.size(); ++cameraIdx)
+				{
+					RenderDifference const difference{ CompareHits(referenceVec[sceneIdx * cameraArr.size() + cameraIdx], RenderHits(*sceneUPtrVec[sceneIdx], cameraArr[cameraIdx])) };
+					++testedCount;
+
+					float const differingRatio{ static_cast<float>(difference.GetDifferingPixels()) / (RenderSize * RenderSize) };
+					if (differingRatio > MaxDifferingPixelRatio)
+					{
+						std::string const name{ "scene " + std::to_string(sceneIdx) + " camera " + std::to_string(cameraIdx) + ", " + settings.GetName() };
+						ReportFailure(name, difference.GetDescription(), knownFailures, failedCount, knownCount);
+					}
+				}
+			}
+		}
+	}
+
+	originalSettings.Apply();
+	Scene::m_UseHitRefinement = originalHitRefinement;
+
+	std::cout << testedCount - failedCount - knownCount << " of " << testedCount << " renders match brute force, " << knownCount << " known failures\n";
+	return failedCount == 0;
+}
+
+bool sdf::Validation::ValidateBounds(KnownFailureSet const& knownFailures)
+{
+	std::cout << "Bounds against the distance functions, a " << BoundGridResolution << "^3 grid and " << RefinedBoundSamples << " gradient ascents per bound\n";
+
+	bool const originalBoxEarlyOut{ Object::m_UseBoxEarlyOut };
+	bool const originalBoxBVH{ BVHNode::m_BoxBVH };
+	//the bounds have to hold for the distance functions themselves, a scaled step only gets shorter
+	bool const originalUseStepScale{ Object::m_UseStepScale };
+	Object::m_UseStepScale = false;
+
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+	std::vector<BoundReport> reportVec{};
+
+	for (size_t sceneIdx{ 0 }; sceneIdx < sceneUPtrVec.size(); ++sceneIdx)
+	{
+		Scene const& scene{ *sceneUPtrVec[sceneIdx] };
+		std::string const scenePrefix{ "scene " + std::to_string(sceneIdx) };
+
+		for (bool const useBox : { false, true })
+		{
+			std::string const volumeName{ useBox ? "box" : "sphere" };
+			Object::m_UseBoxEarlyOut = useBox;
+			BVHNode::m_BoxBVH = useBox;
+
+			//the early out test runs on the point relative to the origin of the object
+			for (size_t objectIdx{ 0 }; objectIdx < scene.GetObjects().size(); ++objectIdx)
+			{
+				Object& object{ *scene.GetObjects()[objectIdx] };
+				BoundReport report
+				{
+					SampleBound(glm::vec3{ 0.f, 0.f, 0.f }, 2.f * object.GetEarlyOutRadius(), [&object](glm::vec3 const& point)
+						{
+							HitRecord hitRecord{};
+							float const boundDistance{ object.GetDistance(point, true, hitRecord) };
+							return boundDistance - object.GetDistance(point, false, hitRecord);
+						})
+				};
+				report.Name = scenePrefix + " object " + std::to_string(objectIdx) + " (" + object.GetTypeName() + ") " + volumeName + " early out";
+				reportVec.emplace_back(std::move(report));
+			}
+
+			if (scene.GetBVHRoot() == nullptr)
+			{
+				continue;
+			}
+
+			//inside the margin the node hands the query to its children, so only the distance it returns outside of it counts
+			std::vector<BVHNode const*> nodeVec{};
+			scene.GetBVHRoot()->CollectNodes(nodeVec);
+			for (size_t nodeIdx{ 0 }; nodeIdx < nodeVec.size(); ++nodeIdx)
+			{
+				BVHNode const& node{ *nodeVec[nodeIdx] };
+				std::vector<Object*> objectVec{};
+				node.CollectObjects(objectVec);
+
+				BoundReport report
+				{
+					SampleBound(node.GetOrigin(), 2.f * node.GetRadius(), [&node, &objectVec](glm::vec3 const& point)
+						{
+							float const boundDistance{ node.GetBoundDistance(point) };
+							if (boundDistance <= BVHNode::m_BoundMargin)
+							{
+								return -FLT_MAX;
+							}
+
+							HitRecord hitRecord{};
+							float surfaceDistance{ FLT_MAX };
+							for (Object* objectPtr : objectVec)
+							{
+								surfaceDistance = glm::min(surfaceDistance, objectPtr->GetDistance(point - objectPtr->Origin(), false, hitRecord));
+							}
+							return boundDistance - surfaceDistance;
+						})
+				};
+				report.Name = scenePrefix + " bvh node " + std::to_string(nodeIdx) + " with " + std::to_string(objectVec.size()) + " objects, " + volumeName;
+				reportVec.emplace_back(std::move(report));
+			}
+		}
+	}
+
+	Object::m_UseBoxEarlyOut = originalBoxEarlyOut;
+	BVHNode::m_BoxBVH = originalBoxBVH;
+	Object::m_UseStepScale = originalUseStepScale;
+
+	//worst violations first
+	std::sort(reportVec.begin(), reportVec.end(),
+		[](BoundReport const& a, BoundReport const& b)
+		{
+			return a.WorstExcess > b.WorstExcess;
+		});
+
+	int failedCount{ 0 };
+	int knownCount{ 0 };
+	for (BoundReport const& report : reportVec)
+	{
+		if (report.Violations == 0)
+		{
+			continue;
+		}
+
+		std::string const details
+		{
+			std::to_string(report.Violations) + " of " + std::to_string(report.Samples) + " samples overstep, worst by " + std::to_string(report.WorstExcess)
+			+ " at (" + std::to_string(report.WorstPoint.x) + ", " + std::to_string(report.WorstPoint.y) + ", " + std::to_string(report.WorstPoint.z) + ")"
+		};
+		ReportFailure(report.Name, details, knownFailures, failedCount, knownCount);
+	}
+
+	std::cout << reportVec.size() - failedCount - knownCount << " of " << reportVec.size() << " bounds are conservative, " << knownCount << " known failures\n";
+	return failedCount == 0;
+}
+
+bool sdf::Validation::ValidateRendererPaths(KnownFailureSet const& knownFailures)
+{
+	std::cout << "Renderer paths against a full trace, " << RendererPathSize << "x" << RendererPathSize << " per camera\n";
+
+	RendererSettings const originalSettings{ RendererSettings::Capture() };
+
+	Profiler profiler{};
+	std::array<Camera, 2> const cameraArr{ CreateCameras() };
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+	Camera const originalCamera{ sceneUPtrVec.front()->GetCamera() };
+
+	//the records go through the quantized hit buffer, the same way the next frame and the shading read them
+	auto const readHitRecords
+	{
+		[](Renderer const& renderer)
+		{
+			glm::ivec2 const renderDimensions{ renderer.GetRenderDimensions() };
+			std::vector<HitRecord> hitRecordVec(renderDimensions.x * renderDimensions.y);
+			for (uint32_t pixelIdx{ 0 }; pixelIdx < hitRecordVec.size(); ++pixelIdx)
+			{
+				hitRecordVec[pixelIdx] = renderer.GetHitBuffer().Load(pixelIdx);
+			}
+			return hitRecordVec;
+		}
+	};
+
+	int failedCount{ 0 };
+	int knownCount{ 0 };
+	int testedCount{ 0 };
+	for (float const renderScale : { 1.f, 0.5f })
+	{
+		for (size_t sceneIdx{ 0 }; sceneIdx < sceneUPtrVec.size(); ++sceneIdx)
+		{
+			Scene const& scene{ *sceneUPtrVec[sceneIdx] };
+			for (size_t cameraIdx{ 0 }; cameraIdx < cameraArr.size(); ++cameraIdx)
+			{
+				Camera const& camera{ cameraArr[cameraIdx] };
+				Camera const historyCamera{ camera.origin + camera.right * HistoryCameraOffset, camera.fovAngle, camera.forward };
+
+				//the debug views trace every pixel from scratch and keep their hit records
+				RendererSettings{ false, false, false, renderScale, Renderer::DebugView::Steps }.Apply();
+				Scene::SetCamera(camera);
+				Renderer const referenceRenderer{ RendererPathSize, RendererPathSize, profiler, true };
+				referenceRenderer.RenderDetached(scene);
+				std::vector<HitRecord> const referenceVec{ readHitRecords(referenceRenderer) };
+
+				//every combination of the three on a renderer without history, which only the settings themselves can keep,
+				//a frame from the side first so the checked frame has history to reuse
+				for (int settingBits{ 1 }; settingBits < 8; ++settingBits)
+				{
+					RendererSettings const settings{ (settingBits & 1) != 0, (settingBits & 2) != 0, (settingBits & 4) != 0, renderScale };
+					settings.Apply();
+					Renderer const renderer{ RendererPathSize, RendererPathSize, profiler, true };
+					Scene::SetCamera(historyCamera);
+					renderer.RenderDetached(scene);
+					Scene::SetCamera(camera);
+					renderer.RenderDetached(scene);
+					++testedCount;
+
+					std::string const name{ "renderer scene " + std::to_string(sceneIdx) + " camera " + std::to_string(cameraIdx) + ", " + settings.GetName() };
+					if (not renderer.HasHitRecords())
+					{
+						ReportFailure(name, "the frame stored no hit records", knownFailures, failedCount, knownCount);
+						continue;
+					}
+
+					RenderDifference const difference{ CompareHits(referenceVec, readHitRecords(renderer), settings.GetRelativeDepthTolerance()) };
+					float const differingRatio{ static_cast<float>(difference.GetDifferingPixels()) / referenceVec.size() };
+					if (differingRatio > (settings.FillsPixels() ? MaxFilledPixelRatio : MaxDifferingPixelRatio))
+					{
+						ReportFailure(name, difference.GetDescription(), knownFailures, failedCount, knownCount);
+					}
+				}
+			}
+		}
+	}
+
+	originalSettings.Apply();
+	Scene::SetCamera(originalCamera);
+
+	std::cout << testedCount - failedCount - knownCount << " of " << testedCount << " renderer paths match a full trace, " << knownCount << " known failures\n";
+	return failedCount == 0;
+}
+
+bool sdf::Validation::ValidateCheckerboard(KnownFailureSet const& knownFailures)
+{
+	std::cout << "Checkerboard against a full trace, " << RendererPathSize << "x" << RendererPathSize << " per camera\n";
+
+	RendererSettings const originalSettings{ RendererSettings::Capture() };
+	bool const originalProfilePrimitives{ PrimitiveProfiler::m_Enabled };
+	PrimitiveProfiler::m_Enabled = true;
+
+	Profiler profiler{};
+	std::array<Camera, 2> const cameraArr{ CreateCameras() };
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+	Camera const originalCamera{ sceneUPtrVec.front()->GetCamera() };
+
+	auto const readHitRecords
+	{
+		[](Renderer const& renderer)
+		{
+			std::vector<HitRecord> hitRecordVec(RendererPathSize * RendererPathSize);
+			for (uint32_t pixelIdx{ 0 }; pixelIdx < hitRecordVec.size(); ++pixelIdx)
+			{
+				hitRecordVec[pixelIdx] = renderer.GetHitBuffer().Load(pixelIdx);
+			}
+			return hitRecordVec;
+		}
+	};
+
+	//every evaluation and early out of the last frame, whatever the tracer did for a pixel ends up in one of them
+	auto const getFrameWork
+	{
+		[]()
+		{
+			int64_t work{ 0 };
+			for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+			{
+				PrimitiveProfiler::TypeCost const& typeCost{ PrimitiveProfiler::GetTypeCost(static_cast<PrimitiveType>(typeIdx)) };
+				work += typeCost.Evaluations + typeCost.EarlyOuts;
+			}
+			return work;
+		}
+	};
+
+	//what the pixels a checkerboard frame has to trace cost in the full trace, the larger of both parities
+	auto const getExpectedWork
+	{
+		[](std::vector<HitRecord> const& referenceVec)
+		{
+			constexpr int size{ static_cast<int>(RendererPathSize) };
+			auto const neighboursDisagree
+			{
+				[&](int px, int py)
+				{
+					std::vector<HitRecord const*> neighbourVec{};
+					for (glm::ivec2 const neighbour : { glm::ivec2{ px - 1, py }, glm::ivec2{ px + 1, py }, glm::ivec2{ px, py - 1 }, glm::ivec2{ px, py + 1 } })
+					{
+						if (neighbour.x >= 0 and neighbour.y >= 0 and neighbour.x < size and neighbour.y < size)
+						{
+							neighbourVec.emplace_back(&referenceVec[neighbour.y * size + neighbour.x]);
+						}
+					}
+
+					float minDistance{ FLT_MAX };
+					float maxDistance{ 0.f };
+					for (HitRecord const* neighbourPtr : neighbourVec)
+					{
+						if (neighbourPtr->DidHit != neighbourVec.front()->DidHit or neighbourPtr->ObjectID != neighbourVec.front()->ObjectID)
+						{
+							return true;
+						}
+						if (neighbourPtr->DidHit)
+						{
+							minDistance = glm::min(minDistance, neighbourPtr->Distance);
+							maxDistance = glm::max(maxDistance, neighbourPtr->Distance);
+						}
+					}
+					return neighbourVec.front()->DidHit and maxDistance - minDistance > minDistance * Renderer::m_CheckerboardDepthTolerance;
+				}
+			};
+
+			int64_t expectedWork{ 0 };
+			for (int parity{ 0 }; parity < 2; ++parity)
+			{
+				int64_t parityWork{ 0 };
+				for (int py{ 0 }; py < size; ++py)
+				{
+					for (int px{ 0 }; px < size; ++px)
+					{
+						if (((px + py + parity) & 1) == 0 or neighboursDisagree(px, py))
+						{
+							HitRecord const& hitRecord{ referenceVec[py * size + px] };
+							parityWork += hitRecord.PrimitiveEvaluations + hitRecord.EarlyOutUsage;
+						}
+					}
+				}
+				expectedWork = glm::max(expectedWork, parityWork);
+			}
+			return expectedWork;
+		}
+	};
+
+	int failedCount{ 0 };
+	int knownCount{ 0 };
+	int testedCount{ 0 };
+	for (size_t sceneIdx{ 0 }; sceneIdx < sceneUPtrVec.size(); ++sceneIdx)
+	{
+		Scene const& scene{ *sceneUPtrVec[sceneIdx] };
+		for (size_t cameraIdx{ 0 }; cameraIdx < cameraArr.size(); ++cameraIdx)
+		{
+			Camera const& camera{ cameraArr[cameraIdx] };
+			Camera const historyCamera{ camera.origin + camera.right * HistoryCameraOffset, camera.fovAngle, camera.forward };
+
+			//the debug views trace every pixel from scratch and keep their hit records
+			RendererSettings{ false, false, false, 1.f, Renderer::DebugView::Steps }.Apply();
+			Scene::SetCamera(camera);
+			Renderer const fullRenderer{ RendererPathSize, RendererPathSize, profiler, true };
+			fullRenderer.RenderDetached(scene);
+			int64_t const fullWork{ getFrameWork() };
+			std::vector<HitRecord> const referenceVec{ readHitRecords(fullRenderer) };
+
+			//the frame from the side is traced in full, the one after it only has to trace half
+			RendererSettings{ false, true }.Apply();
+			Renderer const checkerboardRenderer{ RendererPathSize, RendererPathSize, profiler, true };
+			Scene::SetCamera(historyCamera);
+			checkerboardRenderer.RenderDetached(scene);
+			Scene::SetCamera(camera);
+			checkerboardRenderer.RenderDetached(scene);
+			int64_t const checkerboardWork{ getFrameWork() };
+			++testedCount;
+
+			std::string const namePrefix{ "checkerboard scene " + std::to_string(sceneIdx) + " camera " + std::to_string(cameraIdx) };
+			int64_t const expectedWork{ getExpectedWork(referenceVec) };
+			if (static_cast<float>(checkerboardWork) > expectedWork * MaxCheckerboardWorkRatio)
+			{
+				ReportFailure(namePrefix + " work", std::to_string(checkerboardWork) + " evaluations, the pixels it has to trace took " + std::to_string(expectedWork)
+					+ " of " + std::to_string(fullWork) + " in a full trace", knownFailures, failedCount, knownCount);
+			}
+
+			//the other half gets traced now and the half from the frame before is exact, the view did not change since
+			checkerboardRenderer.RenderDetached(scene);
+			++testedCount;
+
+			RenderDifference const difference{ CompareHits(referenceVec, readHitRecords(checkerboardRenderer)) };
+			if (difference.GetDifferingPixels() > 0 or checkerboardRenderer.IsCheckerboardPending())
+			{
+				ReportFailure(namePrefix + " completion", difference.GetDescription() + (checkerboardRenderer.IsCheckerboardPending() ? ", still pending" : ""), knownFailures, failedCount, knownCount);
+			}
+		}
+	}
+
+	originalSettings.Apply();
+	PrimitiveProfiler::m_Enabled = originalProfilePrimitives;
+	Scene::SetCamera(originalCamera);
+
+	std::cout << testedCount - failedCount - knownCount << " of " << testedCount << " checkerboard frames trace only what they have to and complete, " << knownCount << " known failures\n";
+	return failedCount == 0;
+}
+
+bool sdf::Validation::ValidateDisocclusion(KnownFailureSet const& knownFailures)
+{
+	std::cout << "Reprojection after disocclusion against a full trace, " << RendererPathSize << "x" << RendererPathSize << " per camera\n";
+
+	RendererSettings const originalSettings{ RendererSettings::Capture() };
+
+	Profiler profiler{};
+	std::array<Camera, 2> const cameraArr{ CreateCameras() };
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+	Camera const originalCamera{ sceneUPtrVec.front()->GetCamera() };
+
+	auto const readHitRecords
+	{
+		[](Renderer const& renderer)
+		{
+			std::vector<HitRecord> hitRecordVec(RendererPathSize * RendererPathSize);
+			for (uint32_t pixelIdx{ 0 }; pixelIdx < hitRecordVec.size(); ++pixelIdx)
+			{
+				hitRecordVec[pixelIdx] = renderer.GetHitBuffer().Load(pixelIdx);
+			}
+			return hitRecordVec;
+		}
+	};
+
+	int failedCount{ 0 };
+	int knownCount{ 0 };
+	int testedCount{ 0 };
+	for (size_t sceneIdx{ 0 }; sceneIdx < sceneUPtrVec.size(); ++sceneIdx)
+	{
+		Scene const& scene{ *sceneUPtrVec[sceneIdx] };
+		for (size_t cameraIdx{ 0 }; cameraIdx < cameraArr.size(); ++cameraIdx)
+		{
+			Camera const& camera{ cameraArr[cameraIdx] };
+
+			//the debug views trace every pixel from scratch and keep their hit records
+			RendererSettings{ false, false, false, 1.f, Renderer::DebugView::Steps }.Apply();
+			Scene::SetCamera(camera);
+			Renderer const referenceRenderer{ RendererPathSize, RendererPathSize, profiler, true };
+			referenceRenderer.RenderDetached(scene);
+			std::vector<HitRecord> const referenceVec{ readHitRecords(referenceRenderer) };
+
+			//from the side the objects in front hide other parts of the scene, turned away the edge of the frame was never seen
+			glm::vec3 const turnedForward{ glm::rotate(glm::mat4{ 1.f }, glm::radians(DisocclusionTurnAngle), camera.up) * glm::vec4{ camera.forward, 0.f } };
+			std::array<std::pair<std::string, Camera>, 2> const historyCameraArr
+			{
+				std::pair{ std::string{ "moved" }, Camera{ camera.origin + camera.right * DisocclusionCameraOffset, camera.fovAngle, camera.forward } },
+				std::pair{ std::string{ "turned" }, Camera{ camera.origin, camera.fovAngle, glm::normalize(turnedForward) } }
+			};
+
+			RendererSettings{ true }.Apply();
+			for (auto const& [moveName, historyCamera] : historyCameraArr)
+			{
+				Renderer const renderer{ RendererPathSize, RendererPathSize, profiler, true };
+				Scene::SetCamera(historyCamera);
+				renderer.RenderDetached(scene);
+				Scene::SetCamera(camera);
+				renderer.RenderDetached(scene);
+				++testedCount;
+
+				RenderDifference const difference{ CompareHits(referenceVec, readHitRecords(renderer)) };
+				if (static_cast<float>(difference.GetDifferingPixels()) / referenceVec.size() > MaxDifferingPixelRatio)
+				{
+					std::string const name{ "disocclusion scene " + std::to_string(sceneIdx) + " camera " + std::to_string(cameraIdx) + ", " + moveName };
+					ReportFailure(name, difference.GetDescription(), knownFailures, failedCount, knownCount);
+				}
+			}
+		}
+	}
+
+	originalSettings.Apply();
+	Scene::SetCamera(originalCamera);
+
+	std::cout << testedCount - failedCount - knownCount << " of " << testedCount << " disoccluded frames match a full trace, " << knownCount << " known failures\n";
+	return failedCount == 0;
+}
+
+bool sdf::Validation::EstimateStepScales(std::string const& outputFileName)
+{
+	std::cout << "Lipschitz constants of the distance functions, " << LipschitzSamples << " samples per object\n";
+
+	//the raw distance functions are measured, not the ones already scaled down
+	bool const originalUseStepScale{ Object::m_UseStepScale };
+	Object::m_UseStepScale = false;
+
+	std::vector<std::unique_ptr<Scene>> const sceneUPtrVec{ CreateScenes() };
+
+	std::array<std::vector<float>, PrimitiveTypeCount> gradientVecArr{};
+	std::array<float, PrimitiveTypeCount> maxSlopeArr{};
+	std::array<bool, PrimitiveTypeCount> sampledArr{};
+
+	std::mt19937 generator{ 0 };
+	std::uniform_real_distribution<float> distribution{ -1.f, 1.f };
+	auto const randomOffset{ [&]() { return glm::vec3{ distribution(generator), distribution(generator), distribution(generator) }; } };
+
+	for (std::unique_ptr<Scene> const& sceneUPtr : sceneUPtrVec)
+	{
+		for (std::unique_ptr<Object> const& objectUPtr : sceneUPtr->GetObjects())
+		{
+			Object& object{ *objectUPtr };
+			int const typeIdx{ static_cast<int>(object.GetType()) };
+			sampledArr[typeIdx] = true;
+
+			HitRecord hitRecord{};
+			auto const getDistance{ [&](glm::vec3 const& point) { return object.GetDistance(point, false, hitRecord); } };
+
+			//around the object, where the tracer evaluates it in full
+			float const halfSize{ 1.5f * object.GetEarlyOutRadius() };
+			for (int sampleIdx{ 0 }; sampleIdx < LipschitzSamples; ++sampleIdx)
+			{
+				glm::vec3 const point{ randomOffset() * halfSize };
+				float const distance{ getDistance(point) };
+				//the tracer only steps from outside, estimators tend to be meaningless inside
+				if (distance <= GradientStep)
+				{
+					continue;
+				}
+
+				glm::vec3 const gradient
+				{
+					getDistance(point + glm::vec3{ GradientStep, 0.f, 0.f }) - getDistance(point - glm::vec3{ GradientStep, 0.f, 0.f }),
+					getDistance(point + glm::vec3{ 0.f, GradientStep, 0.f }) - getDistance(point - glm::vec3{ 0.f, GradientStep, 0.f }),
+					getDistance(point + glm::vec3{ 0.f, 0.f, GradientStep }) - getDistance(point - glm::vec3{ 0.f, 0.f, GradientStep })
+				};
+				float const gradientLength{ glm::length(gradient) / (2.f * GradientStep) };
+
+				//the gradient misses the kinks and creases a step can jump over, so also within the sphere a step from here trusts
+				glm::vec3 const otherPoint{ point + glm::normalize(randomOffset()) * distance * glm::abs(distribution(generator)) };
+				float const pointDistance{ glm::length(otherPoint - point) };
+				float const otherDistance{ getDistance(otherPoint) };
+				float const slope{ pointDistance > GradientStep and otherDistance > 0.f ? glm::abs(otherDistance - distance) / pointDistance : 0.f };
+
+				if (std::isfinite(gradientLength))
+				{
+					gradientVecArr[typeIdx].emplace_back(gradientLength);
+				}
+				if (std::isfinite(slope))
+				{
+					maxSlopeArr[typeIdx] = glm::max(maxSlopeArr[typeIdx], slope);
+				}
+			}
+		}
+	}
+
+	for (int typeIdx{ 0 }; typeIdx < PrimitiveTypeCount; ++typeIdx)
+	{
+		PrimitiveType const type{ static_cast<PrimitiveType>(typeIdx) };
+		if (not sampledArr[typeIdx])
+		{
+			std::cout << GetPrimitiveTypeName(type) << ": not in any scene, step scale stays " << Object::GetStepScale(type) << "\n";
+			continue;
+		}
+
+		std::vector<float>& gradientVec{ gradientVecArr[typeIdx] };
+		float maxGradient{ 0.f };
+		float percentileGradient{ 0.f };
+		if (not gradientVec.empty())
+		{
+			auto const percentileIt{ gradientVec.begin() + static_cast<size_t>((gradientVec.size() - 1) * GradientPercentile) };
+			std::nth_element(gradientVec.begin(), percentileIt, gradientVec.end());
+			percentileGradient = *percentileIt;
+			maxGradient = *std::max_element(percentileIt, gradientVec.end());
+		}
+
+		float const lipschitzConstant{ glm::max(percentileGradient, maxSlopeArr[typeIdx]) };
+		float const stepScale{ lipschitzConstant > 1.f + LipschitzTolerance ? 1.f / lipschitzConstant : 1.f };
+		Object::SetStepScale(type, stepScale);
+
+		std::cout << GetPrimitiveTypeName(type) << ": gradient " << percentileGradient << " (max " << maxGradient << "), max slope " << maxSlopeArr[typeIdx]
+			<< ", step scale " << stepScale << "\n";
+	}
+
+	Object::m_UseStepScale = originalUseStepScale;
+
+	//only written when asked for, a validation run should not leave files behind
+	if (outputFileName.empty())
+	{
+		return true;
+	}
+
+	bool const saved{ Object::SaveStepScales(outputFileName) };
+	std::cout << (saved ? "Step scales saved to " : "Step scales could not be saved to ") << outputFileName << "\n";
+	return saved;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+namespace sdf
+{
+
+	//headless checks of the acceleration modes and the distance functions, run with --validate and by ctest
+	//every check prints its report to the console and returns false when it found a regression
+	class Validation final
+	{
+	public:
+		//names of failures that are expected, they are still printed but do not fail the check
+		using KnownFailureSet = std::unordered_set<std::string>;
+
+		//square resolution of the validation renders, low enough to brute force the mandelbulbs
+		static constexpr uint32_t RenderSize{ 32 };
+		//hit distances further apart than this, or this fraction of the distance, count as a depth difference
+		static constexpr float DepthTolerance{ 0.01f };
+		static constexpr float RelativeDepthTolerance{ 0.001f };
+		//grazing rays may take a different path around a silhouette, only more differing pixels than this fail
+		static constexpr float MaxDifferingPixelRatio{ 0.005f };
+
+		//square window of the renderer path checks, at half render scale it still holds a few adaptive blocks
+		static constexpr uint32_t RendererPathSize{ 64 };
+		//checkerboard and adaptive sampling fill pixels in instead of tracing them, so edges may differ more
+		static constexpr float MaxFilledPixelRatio{ 0.05f };
+		//the history frame is rendered this far to the right of the checked one, so it has to be reprojected
+		static constexpr float HistoryCameraOffset{ 0.1f };
+		//a checkerboard frame traces every other pixel and the ones between traced neighbours that disagree,
+		//its work may only exceed what those pixels cost in a full trace by this ratio
+		static constexpr float MaxCheckerboardWorkRatio{ 1.1f };
+		//the disocclusion history frames are rendered this far to the side, or turned this many degrees away,
+		//so parts of the checked frame were hidden behind other objects or outside the history frame
+		static constexpr float DisocclusionCameraOffset{ 1.5f };
+		static constexpr float DisocclusionTurnAngle{ 25.f };
+
+		//grid points per axis in the cube around every early out volume and bvh node,
+		//the worst cells start a gradient ascent, which halves its step whenever it stops climbing
+		static constexpr int BoundGridResolution{ 25 };
+		static constexpr int RefinedBoundSamples{ 32 };
+		static constexpr int RefinementSteps{ 64 };
+		//a bound may overshoot the surface by less than the hit distance, the tracer stops before it matters
+		static constexpr float BoundTolerance{ 0.001f };
+
+		//points per object for the lipschitz estimate, each gives a gradient and the slope towards a nearby point
+		static constexpr int LipschitzSamples{ 16384 };
+		//central difference step of the gradient
+		static constexpr float GradientStep{ 0.001f };
+		//a jump in a distance estimator shows up as a huge gradient in one sample, the rarest ones are left out
+		static constexpr float GradientPercentile{ 0.999f };
+		//slopes this close to 1 are the rounding of exact distances, not an overestimate
+		static constexpr float LipschitzTolerance{ 0.01f };
+
+		Validation() = delete;
+
+		//estimates the step scales first and runs every other check with them, false when any of them failed
+		//the estimated step scales are only saved when a file name is given
+		static bool Run(std::string const& stepScaleFileName);
+
+		//one failure name per line as printed after FAIL, empty lines and lines starting with # are skipped
+		//a missing file is an empty baseline
+		static KnownFailureSet LoadKnownFailures(std::string const& fileName);
+
+		//renders every scene at fixed cameras with every combination of early out and bvh settings
+		//and compares hits, object ids and depths against brute force
+		static bool ValidateRenderModes(KnownFailureSet const& knownFailures = {});
+		//searches every early out volume and bvh node for points where the bound is further than the surface,
+		//which would make the sphere tracer step through it
+		static bool ValidateBounds(KnownFailureSet const& knownFailures = {});
+		//renders every scene through a headless renderer with every combination of reprojection, checkerboard,
+		//adaptive sampling and render scale after a camera move, and compares its hit records against a full trace
+		static bool ValidateRendererPaths(KnownFailureSet const& knownFailures = {});
+		//counts the distance evaluations of a checkerboard frame without reprojection against what the pixels it has to trace
+		//cost in a full trace, then checks that one more frame from the same view completes it into exactly the full trace
+		static bool ValidateCheckerboard(KnownFailureSet const& knownFailures = {});
+		//renders every scene with reprojection after a large camera move and a turn, which uncover surfaces the history
+		//never saw, and compares its hit records against a full trace
+		static bool ValidateDisocclusion(KnownFailureSet const& knownFailures = {});
+		//estimates how much faster than the actual distance every primitive type's distance function can change,
+		//sets the step scale of the type to the inverse and saves them to the file unless its name is empty, false when saving failed
+		static bool EstimateStepScales(std::string const& outputFileName);
+	};
+
+}
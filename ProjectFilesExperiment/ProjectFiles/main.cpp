@@ -1,13 +1,68 @@
 #include "SdEngine.h"
 
+#include <string>
+#include <string_view>
+
+#include "TraceRecorder.h"
+#include "PerfCounters.h"
+#include "PrimitiveProfiler.h"
+#include "BVHNode.h"
+#include "Validation.h"
+#include "SDFObjects.h"
+
 int main(int argc, char* args[])
 {
 	constexpr uint32_t width{ 600 };
 	constexpr uint32_t height{ 600 };
 
-	sdf::Engine Engine{ width, height };
+	bool validate{ false };
+	std::string stepScaleFileName{};
+
+	//tracing from the start also records the bounds and bvh builds of the scenes
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		if (std::string_view{ args[argIdx] } == "--trace")
+		{
+			sdf::TraceRecorder::m_Enabled = true;
+		}
+		//the scenes build their bvh in the engine constructor
+		else if (std::string_view{ args[argIdx] } == "--cost-sah")
+		{
+			sdf::BVHNode::m_CostAwareSAH = true;
+		}
+		//headless, no window gets opened
+		else if (std::string_view{ args[argIdx] } == "--validate")
+		{
+			validate = true;
+		}
+		//where --validate saves the step scales it estimated, nothing is written without it
+		else if (std::string_view{ args[argIdx] } == "--step-scales" and argIdx + 1 < argc)
+		{
+			stepScaleFileName = args[++argIdx];
+		}
+	}
+
+	//costs saved by an earlier run replace the calibration of the cost aware sah
+	sdf::PrimitiveProfiler::LoadCosts("primitive_costs.csv");
+	//step scales saved by an earlier --validate --step-scales step_scales.csv run, applied from the first frame
+	sdf::Object::LoadStepScales("step_scales.csv");
+
+	if (validate)
+	{
+		return sdf::Validation::Run(stepScaleFileName) ? 0 : 1;
+	}
+
+	//before the engine, the scenes start the worker threads that have to inherit the counters
+	sdf::PerfCounters::Open();
+
+	{
+		sdf::Engine Engine{ width, height };
+
+		Engine.Run();
+	}
 
-	Engine.Run();
+	//the engine joined its render thread and wrote its files, nothing reads the counters anymore
+	sdf::PerfCounters::Close();
 
 	return -1;
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "Validation.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+//one check of the validation per ctest test, failures listed in the known failures file do not fail it
+int main(int argc, char* args[])
+{
+	if (argc < 2)
+	{
+		std::cout << "usage: " << args[0] << " <render-modes | bounds | renderer-paths | checkerboard | disocclusion> [known failures file]\n";
+		return 1;
+	}
+
+	std::string_view const checkName{ args[1] };
+	sdf::Validation::KnownFailureSet const knownFailures{ argc > 2 ? sdf::Validation::LoadKnownFailures(args[2]) : sdf::Validation::KnownFailureSet{} };
+
+	//the renders trace with the step scales --validate estimates, the same way the application does with a saved file
+	if (checkName != "bounds" and not sdf::Validation::EstimateStepScales(""))
+	{
+		return 1;
+	}
+
+	if (checkName == "render-modes")
+	{
+		return sdf::Validation::ValidateRenderModes(knownFailures) ? 0 : 1;
+	}
+	if (checkName == "bounds")
+	{
+		return sdf::Validation::ValidateBounds(knownFailures) ? 0 : 1;
+	}
+	if (checkName == "renderer-paths")
+	{
+		return sdf::Validation::ValidateRendererPaths(knownFailures) ? 0 : 1;
+	}
+	if (checkName == "checkerboard")
+	{
+		return sdf::Validation::ValidateCheckerboard(knownFailures) ? 0 : 1;
+	}
+	if (checkName == "disocclusion")
+	{
+		return sdf::Validation::ValidateDisocclusion(knownFailures) ? 0 : 1;
+	}
+
+	std::cout << "unknown check " << checkName << "\n";
+	return 1;
+}